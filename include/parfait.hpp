@@ -2,11 +2,25 @@
 #define __PARFAIT_H
 
 #include <parfait/exception.hpp>
+#include <parfait/atomic.hpp>
+#include <parfait/pool.hpp>
+#include <parfait/flat.hpp>
+#include <parfait/iterator.hpp>
+#include <parfait/span.hpp>
+#include <parfait/vm.hpp>
+#include <parfait/allocator.hpp>
+#include <parfait/batch.hpp>
 #include <parfait/memory.hpp>
 #include <parfait/allocated.hpp>
+#include <parfait/small.hpp>
+#include <parfait/shared.hpp>
+#include <parfait/virtual.hpp>
 #include <parfait/transparent.hpp>
+#include <parfait/piecetable.hpp>
 #include <parfait/pointer.hpp>
 #include <parfait/array.hpp>
+#include <parfait/append.hpp>
+#include <parfait/ring.hpp>
 #include <parfait/variadic.hpp>
 
 #endif
@@ -2,37 +2,86 @@
 #define __PARFAIT_ALLOCATED_H
 
 #include <fstream>
+#include <functional>
 
+#include <parfait/allocator.hpp>
+#include <parfait/batch.hpp>
 #include <parfait/memory.hpp>
 
 namespace parfait
 {
+   // what an allocation does with memory it hands out and takes back. zeroing only
+   // touches bytes that didn't come from the old block (all of them on allocate, the grown
+   // tail on reallocate), and wiping uses a write the compiler can't optimize away.
+   enum class FillPolicy : std::uint8_t
+   {
+      None = 0,
+      ZeroOnAllocate = 1,
+      WipeOnFree = 2,
+      ZeroAndWipe = 3
+   };
+
    template <typename Allocator=std::allocator<std::uint8_t>>
    class AllocatedMemory : public Memory
    {
    protected:
       Allocator allocator;
+      FillPolicy policy;
+      // set while the block was adopted from outside rather than taken from the allocator
+      std::function<void(typename Allocator::value_type *, std::size_t)> deleter;
+
+      // hand a block back to whoever allocated it
+      void free_block(typename Allocator::value_type *ptr, std::size_t count) {
+         if (this->deleter)
+         {
+            auto deleter = std::move(this->deleter);
+            this->deleter = nullptr;
+            deleter(ptr, count);
+         }
+         else { this->allocator.deallocate(ptr, count); }
+      }
 
       using Memory::set_memory;
+
+      inline void zero_fill(void *ptr, std::size_t size) const {
+         if ((static_cast<std::uint8_t>(this->policy) & static_cast<std::uint8_t>(FillPolicy::ZeroOnAllocate)) != 0)
+            std::memset(ptr, 0, size);
+      }
+
+      inline void wipe(void *ptr, std::size_t size) const {
+         if ((static_cast<std::uint8_t>(this->policy) & static_cast<std::uint8_t>(FillPolicy::WipeOnFree)) != 0)
+            kernel::secure_zero(ptr, size);
+      }
       
    public:
       using AllocatorType = typename Allocator::value_type;
+      using Deleter = std::function<void(AllocatorType *, std::size_t)>;
+      using ReleasedPtr = std::unique_ptr<AllocatorType[], std::function<void(AllocatorType *)>>;
+      static constexpr FillPolicy DefaultFillPolicy = FillPolicy::ZeroAndWipe;
       
-      AllocatedMemory() : Memory() {
+      AllocatedMemory() : Memory(), policy(DefaultFillPolicy) {
          this->allocator = Allocator();
       }
-      AllocatedMemory(std::size_t size) : Memory() {
+      AllocatedMemory(std::size_t size) : Memory(), policy(DefaultFillPolicy) {
          this->allocator = Allocator();
          this->allocate(size);
       }
-      AllocatedMemory(AllocatorType *ptr, std::size_t size) : Memory() {
+      AllocatedMemory(std::size_t size, FillPolicy policy) : Memory(), policy(policy) {
+         this->allocator = Allocator();
+         this->allocate(size);
+      }
+      AllocatedMemory(AllocatorType *ptr, std::size_t size) : Memory(), policy(DefaultFillPolicy) {
          this->load_data<AllocatorType>(ptr, size);
       }
-      AllocatedMemory(const AllocatedMemory &other) {
+      AllocatedMemory(const AllocatedMemory &other) : policy(other.policy) {
+         // a copy lives in the original's domain, like a view of it would
+         this->_domain = other._domain;
          this->allocate(other.size());
          std::memcpy(this->pointer.m, other.ptr(), this->_size);
       }
       virtual ~AllocatedMemory() {
+         // destructors can't throw, so being pinned doesn't stop the teardown
+         this->tearing_down = true;
          if (this->pointer.c != nullptr) { this->deallocate(); }
       }
 
@@ -49,6 +98,9 @@ namespace parfait
       inline std::size_t byte_size(void) const { return this->_size; }
       inline std::size_t element_size() const { return sizeof(AllocatorType); }
 
+      inline FillPolicy fill_policy() const { return this->policy; }
+      inline void set_fill_policy(FillPolicy policy) { this->policy = policy; }
+
       template <typename T>
       T* cast_ptr(std::size_t offset=0)
       {
@@ -82,6 +134,43 @@ namespace parfait
          return Memory::subsection(fixed_offset, fixed_size);
       }
 
+      std::vector<Memory> subsections(const std::vector<std::pair<std::size_t,std::size_t>> &ranges) {
+         auto fixed_ranges = ranges;
+
+         for (auto &range : fixed_ranges)
+         {
+            range.first *= sizeof(AllocatorType);
+            range.second *= sizeof(AllocatorType);
+         }
+
+         return Memory::subsections(fixed_ranges);
+      }
+
+      template <typename T=AllocatorType>
+      Span<T> span(std::size_t offset, std::size_t size) {
+         return Memory::span<T>(offset * sizeof(AllocatorType), size);
+      }
+
+      template <typename T=AllocatorType>
+      Span<const T> span(std::size_t offset, std::size_t size) const {
+         return Memory::span<T>(offset * sizeof(AllocatorType), size);
+      }
+
+      template <typename T=AllocatorType>
+      Span<T> span() {
+         return Memory::span<T>();
+      }
+
+      template <typename T=AllocatorType>
+      Span<const T> span() const {
+         return Memory::span<T>();
+      }
+
+      Iterator<AllocatorType> begin() { return this->span().begin(); }
+      Iterator<const AllocatorType> begin() const { return this->span().begin(); }
+      Iterator<AllocatorType> end() { return this->span().end(); }
+      Iterator<const AllocatorType> end() const { return this->span().end(); }
+
       template <typename T>
       std::vector<T> read(std::size_t offset, std::size_t size) const
       {
@@ -94,6 +183,28 @@ namespace parfait
          return Memory::read<T>(fixed_offset, size);
       }
 
+      template <typename T>
+      void read_into(std::size_t offset, T* dest, std::size_t size) const
+      {
+         auto fixed_offset = offset * sizeof(AllocatorType);
+         auto end_offset = fixed_offset + size * sizeof(T);
+
+         if (end_offset % sizeof(AllocatorType) != 0) { throw exception::BadAlignment(end_offset, sizeof(AllocatorType)); }
+
+         Memory::read_into<T>(fixed_offset, dest, size);
+      }
+
+      template <typename T>
+      Span<const T> read_view(std::size_t offset, std::size_t size) const
+      {
+         auto fixed_offset = offset * sizeof(AllocatorType);
+         auto end_offset = fixed_offset + size * sizeof(T);
+
+         if (end_offset % sizeof(AllocatorType) != 0) { throw exception::BadAlignment(end_offset, sizeof(AllocatorType)); }
+
+         return Memory::read_view<T>(fixed_offset, size);
+      }
+
       template <typename T>
       std::vector<T> read_unaligned(std::size_t offset, std::size_t size) const
       {
@@ -204,6 +315,29 @@ namespace parfait
          this->end_with_unaligned<T>(&ref);
       }
 
+      // offsets and sizes are in units of the allocator type; the final repetition of
+      // the pattern is truncated if it doesn't fit
+      template <typename T>
+      void fill(std::size_t offset, std::size_t size, const T* pattern, std::size_t pattern_size) {
+         Memory::fill<T>(offset * sizeof(AllocatorType), size * sizeof(AllocatorType), pattern, pattern_size);
+      }
+
+      template <typename T>
+      void fill(std::size_t offset, std::size_t size, const T& pattern) {
+         this->fill<T>(offset, size, &pattern, 1);
+      }
+
+      void copy_from(const Memory &source, std::size_t source_offset, std::size_t offset, std::size_t size) {
+         Memory::copy_from(source,
+                           source_offset * sizeof(AllocatorType),
+                           offset * sizeof(AllocatorType),
+                           size * sizeof(AllocatorType));
+      }
+
+      void move_within(std::size_t source_offset, std::size_t offset, std::size_t size) {
+         this->copy_from(*this, source_offset, offset, size);
+      }
+
       template <typename T>
       std::vector<std::size_t> search(const T* ptr, std::size_t size) const
       {
@@ -292,27 +426,60 @@ namespace parfait
          if (this->pointer.c != nullptr) { this->deallocate(); }
          
          auto ptr = this->allocator.allocate(size);
-         std::memset(ptr, 0, size * sizeof(AllocatorType));
+         this->zero_fill(ptr, size * sizeof(AllocatorType));
          this->set_memory(ptr, size * sizeof(AllocatorType));
       }
 
       virtual void deallocate() {
          auto corrected_size = this->_size / sizeof(AllocatorType);
          this->manager().invalidate(this);
-         std::memset(this->pointer.m, 0, this->_size);
-         this->allocator.deallocate(static_cast<AllocatorType * const>(this->pointer.m), corrected_size);
+         this->wipe(this->pointer.m, this->_size);
+         this->free_block(static_cast<AllocatorType * const>(this->pointer.m), corrected_size);
          this->set_memory(reinterpret_cast<const void *>(nullptr), 0);
       }
 
       virtual void reallocate(std::size_t size) {
          if (size == 0) { throw exception::ZeroSize(); }
          if (this->pointer.c == nullptr) { return this->allocate(size); }
-         
+
+         // refuse before the allocator gets a chance to move the block out from under a pin
+         this->manager().check_unpinned(this);
+
+         if constexpr (has_reallocate<Allocator>::value)
+         {
+            auto old_ptr = static_cast<AllocatorType *>(this->pointer.m);
+            auto old_size = this->_size;
+            auto new_size = sizeof(AllocatorType) * size;
+            auto secure = (static_cast<std::uint8_t>(this->policy) & static_cast<std::uint8_t>(FillPolicy::WipeOnFree)) != 0;
+
+            if (new_size == old_size) { return; }
+
+            // borrowers copy out of our bytes, so they have to go before the block can move
+            this->manager().detach_borrowers(this);
+
+            if (new_size < old_size) { this->wipe(reinterpret_cast<std::uint8_t *>(old_ptr)+new_size, old_size-new_size); }
+
+            // an adopted block didn't come from the allocator, so it can't be resized by it
+            auto resized_ptr = (this->deleter) ? nullptr : this->allocator.reallocate(old_ptr, old_size / sizeof(AllocatorType), size, secure);
+
+            if (resized_ptr != nullptr)
+            {
+               if (new_size > old_size) { this->zero_fill(reinterpret_cast<std::uint8_t *>(resized_ptr)+old_size, new_size-old_size); }
+
+               // the map only needs rewriting when the base actually changed
+               if (resized_ptr == old_ptr) { this->manager().resize(this, new_size); }
+               else { this->manager().move(this, resized_ptr, new_size); }
+
+               return;
+            }
+         }
+
          auto new_ptr = this->allocator.allocate(size);
          auto new_size = sizeof(AllocatorType) * size;
          auto copy_size = std::min(this->_size, new_size);
 
-         std::memset(new_ptr, 0, new_size);
+         // the front of the new block is about to be overwritten, so only the grown tail needs zeroing
+         if (new_size > copy_size) { this->zero_fill(reinterpret_cast<std::uint8_t *>(new_ptr)+copy_size, new_size-copy_size); }
          
          auto old_ptr = static_cast<AllocatorType *const>(this->pointer.m);
          auto old_size = this->_size;
@@ -321,8 +488,72 @@ namespace parfait
          std::memcpy(new_ptr, old_ptr, copy_size);
          this->manager().move(this, new_ptr, new_size);
 
-         std::memset(old_ptr, 0, old_size);
-         this->allocator.deallocate(old_ptr, corrected_size);
+         this->wipe(old_ptr, old_size);
+         this->free_block(old_ptr, corrected_size);
+      }
+
+      // take ownership of a block allocated elsewhere without copying it. the deleter is
+      // called with the pointer and element count when the block is freed, including when
+      // a reallocation moves the contents into the allocator's own memory.
+      virtual void adopt(AllocatorType *ptr, std::size_t size, Deleter deleter) {
+         if (ptr == nullptr) { throw exception::NullPointer(); }
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+
+         this->set_memory(ptr, size * sizeof(AllocatorType));
+         this->deleter = std::move(deleter);
+      }
+
+      template <typename UniqueDeleter>
+      void adopt(std::unique_ptr<AllocatorType[], UniqueDeleter> ptr, std::size_t size) {
+         auto raw = ptr.get();
+         auto unique_deleter = ptr.get_deleter();
+
+         this->adopt(raw, size, [unique_deleter](AllocatorType *ptr, std::size_t) mutable { unique_deleter(ptr); });
+         ptr.release();
+      }
+
+      void adopt(std::vector<AllocatorType> &&vec) {
+         if (vec.size() == 0) { throw exception::ZeroSize(); }
+
+         // the vector keeps owning its storage, we just keep the vector alive
+         auto holder = new std::vector<AllocatorType>(std::move(vec));
+
+         try {
+            this->adopt(holder->data(), holder->size(), [holder](AllocatorType *, std::size_t) { delete holder; });
+         }
+         catch (...) {
+            delete holder;
+            throw;
+         }
+      }
+
+      // give up ownership of the block without copying it. the returned pointer frees it the
+      // way it was allocated, and views of this object are invalidated since the manager no
+      // longer tracks its lifetime.
+      virtual std::pair<ReleasedPtr,std::size_t> release() {
+         if (this->pointer.c == nullptr) { throw exception::NotAllocated(); }
+
+         auto ptr = static_cast<AllocatorType *>(this->pointer.m);
+         auto count = this->_size / sizeof(AllocatorType);
+         std::function<void(AllocatorType *)> release_deleter;
+
+         if (this->deleter)
+         {
+            auto deleter = std::move(this->deleter);
+            this->deleter = nullptr;
+            release_deleter = [deleter, count](AllocatorType *ptr) { deleter(ptr, count); };
+         }
+         else
+         {
+            auto allocator = this->allocator;
+            release_deleter = [allocator, count](AllocatorType *ptr) mutable { allocator.deallocate(ptr, count); };
+         }
+
+         this->manager().invalidate(this);
+         this->set_memory(static_cast<const void *>(nullptr), 0);
+
+         return std::make_pair(ReleasedPtr(ptr, release_deleter), count);
       }
 
       template <typename T>
@@ -401,18 +632,13 @@ namespace parfait
          auto byte_size = ((std::is_same<T,void>::value) ? 1 : sizeof(T)) * size;
          if (byte_size % sizeof(AllocatorType) != 0) { throw exception::BadAlignment(byte_size, sizeof(AllocatorType)); }
          
-         std::vector<std::uint8_t> split_data;
-
          if (fixed_offset == this->_size) { return this->append<T>(ptr, size); }
-         else if (offset == 0) { split_data = this->read<std::uint8_t>(0, this->_size); }
-         else {
-            auto split_point = this->split_at(offset);
-            split_data = split_point.second.read<std::uint8_t>(0, split_point.second.size());
-         }
 
+         // grow in place, then slide the tail over to make room for the new data
+         auto tail_size = this->_size - fixed_offset;
          this->reallocate((this->_size + byte_size) / sizeof(AllocatorType));
+         Memory::move_within(fixed_offset, fixed_offset + byte_size, tail_size);
          this->write<T>(offset, ptr, size);
-         this->write<std::uint8_t>(offset + (byte_size / sizeof(AllocatorType)), split_data.data(), split_data.size());
       }
 
       template <typename T>
@@ -425,21 +651,74 @@ namespace parfait
          this->insert<T>(offset, &ref);
       }
 
-      void erase(std::size_t offset, std::size_t size)
+      virtual void erase(std::size_t offset, std::size_t size)
       {
          auto fixed_offset = offset * sizeof(AllocatorType);
          auto fixed_size = size * sizeof(AllocatorType);
          auto end_offset = fixed_offset + fixed_size;
-         std::vector<std::uint8_t> end_data;
 
+         if (end_offset > this->_size) { throw exception::OutOfBounds(end_offset, this->_size); }
+         if (size == 0) { return; }
+
+         // a refused shrink after the slide would leave the contents rearranged
+         this->manager().check_unpinned(this);
+
+         // slide the tail down over the erased region, then shrink
          if (end_offset != this->_size)
-            end_data = this->read<std::uint8_t>(offset, (this->_size-end_offset) / sizeof(AllocatorType));
+            Memory::move_within(end_offset, fixed_offset, this->_size-end_offset);
 
          auto size_delta = this->_size - fixed_size;
-         this->reallocate(size_delta / sizeof(AllocatorType));
 
-         if (end_data.size() > 0)
-            this->write<std::uint8_t>(offset, end_data.data(), end_data.size());
+         if (size_delta == 0) { this->deallocate(); }
+         else { this->reallocate(size_delta / sizeof(AllocatorType)); }
+      }
+
+      // apply a whole batch of edits with at most one resize, so dependent views are
+      // relocated once instead of per edit. every edit is checked before anything changes.
+      void apply(const WriteBatch<AllocatorType> &batch) {
+         if (batch.is_empty()) { return; }
+
+         auto layout = batch.layout(this->_size);
+         auto old_size = this->_size;
+         auto staged = batch.staged_data();
+
+         if (layout.in_place)
+         {
+            auto base = static_cast<std::uint8_t *>(Memory::write_ptr());
+
+            this->lock();
+
+            for (auto &piece : layout.pieces)
+               kernel::copy(base+piece.dest, staged+piece.source, piece.size);
+
+            this->unlock();
+            return;
+         }
+
+         // a refused resize partway through would leave the contents rearranged
+         this->manager().check_unpinned(this);
+
+         if (layout.size == 0) { return this->deallocate(); }
+         if (layout.size > old_size) { this->reallocate(layout.size / sizeof(AllocatorType)); }
+
+         auto base = static_cast<std::uint8_t *>(Memory::write_ptr());
+
+         this->lock();
+
+         // a kept run never lands on one still waiting to move: runs headed left go in
+         // order, runs headed right go in reverse, and the staged data goes in last
+         for (auto &piece : layout.pieces)
+            if (!piece.staged && piece.dest < piece.source) { kernel::move(base+piece.dest, base+piece.source, piece.size); }
+
+         for (auto piece=layout.pieces.rbegin(); piece!=layout.pieces.rend(); ++piece)
+            if (!piece->staged && piece->dest > piece->source) { kernel::move(base+piece->dest, base+piece->source, piece->size); }
+
+         for (auto &piece : layout.pieces)
+            if (piece.staged) { kernel::copy(base+piece.dest, staged+piece.source, piece.size); }
+
+         this->unlock();
+
+         if (layout.size < old_size) { this->reallocate(layout.size / sizeof(AllocatorType)); }
       }
 
       AllocatedMemory split_off(std::size_t midpoint) {
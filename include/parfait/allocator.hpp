@@ -0,0 +1,152 @@
+#ifndef __PARFAIT_ALLOCATOR_H
+#define __PARFAIT_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <parfait/vm.hpp>
+
+namespace parfait
+{
+   // allocators that can resize a block themselves provide
+   // reallocate(ptr, old_count, new_count, secure), which AllocatedMemory prefers over
+   // allocating, copying and freeing
+   template <typename Allocator, typename=void>
+   struct has_reallocate : std::false_type {};
+
+   template <typename Allocator>
+   struct has_reallocate<Allocator, std::void_t<decltype(std::declval<Allocator &>().reallocate(
+      std::declval<typename Allocator::value_type *>(), std::size_t(), std::size_t(), bool()))>> : std::true_type {};
+
+   // an allocator for trivially copyable types that can grow and shrink without copying.
+   // small blocks come from malloc and are resized with realloc; where mremap is available,
+   // blocks of MapThreshold bytes or more are mapped directly and resized by moving their pages.
+   template <typename T>
+   class ReallocAllocator
+   {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "ReallocAllocator can only relocate trivially copyable types.");
+
+   public:
+      using value_type = T;
+      static constexpr std::size_t MapThreshold = static_cast<std::size_t>(1) << 20;
+
+      ReallocAllocator() noexcept {}
+      template <typename U>
+      ReallocAllocator(const ReallocAllocator<U> &) noexcept {}
+
+      static bool is_mapped(std::size_t count) {
+#if defined(PARFAIT_VM_REMAP)
+         return count * sizeof(T) >= MapThreshold;
+#else
+         return false;
+#endif
+      }
+
+      T *allocate(std::size_t count) {
+         if (is_mapped(count)) { return static_cast<T *>(vm::map(count * sizeof(T))); }
+
+         auto ptr = std::malloc(count * sizeof(T));
+         if (ptr == nullptr) { throw std::bad_alloc(); }
+
+         return static_cast<T *>(ptr);
+      }
+
+      void deallocate(T *ptr, std::size_t count) {
+         if (is_mapped(count)) { vm::release(ptr, count * sizeof(T)); }
+         else { std::free(ptr); }
+      }
+
+      // resize the block without a copy where the system allows it. returns nullptr and
+      // leaves the block alone when the caller has to allocate, copy and free instead. a
+      // secure resize must not leave the old contents behind in freed memory, which realloc
+      // can't promise.
+      T *reallocate(T *ptr, std::size_t old_count, std::size_t new_count, bool secure) {
+         auto old_mapped = is_mapped(old_count);
+
+         if (old_mapped != is_mapped(new_count)) { return nullptr; }
+
+#if defined(PARFAIT_VM_REMAP)
+         if (old_mapped) { return static_cast<T *>(vm::remap(ptr, old_count * sizeof(T), new_count * sizeof(T))); }
+#endif
+
+         if (secure) { return nullptr; }
+
+         auto result = std::realloc(ptr, new_count * sizeof(T));
+         if (result == nullptr) { throw std::bad_alloc(); }
+
+         return static_cast<T *>(result);
+      }
+   };
+
+   template <typename T, typename U>
+   bool operator==(const ReallocAllocator<T> &, const ReallocAllocator<U> &) { return true; }
+
+   template <typename T, typename U>
+   bool operator!=(const ReallocAllocator<T> &, const ReallocAllocator<U> &) { return false; }
+
+namespace alignment
+{
+   constexpr std::size_t CacheLine = 64;
+   constexpr std::size_t Page = 4096;
+   constexpr std::size_t HugePage = static_cast<std::size_t>(2) << 20;
+}
+
+   // an allocator that aligns every block to Alignment bytes. blocks of HugePageThreshold
+   // bytes or more are aligned and padded to whole huge pages and advised to use transparent
+   // huge pages, cutting TLB misses on large scans. a threshold of zero disables the advice.
+   template <typename T, std::size_t Alignment=alignment::CacheLine, std::size_t HugePageThreshold=alignment::HugePage>
+   class AlignedAllocator
+   {
+      static_assert(Alignment > 0 && (Alignment & (Alignment-1)) == 0, "Alignment must be a power of two.");
+      static_assert(Alignment >= alignof(T), "Alignment must satisfy the type's own alignment.");
+
+      static bool is_huge(std::size_t count) {
+         return HugePageThreshold != 0 && count * sizeof(T) >= HugePageThreshold;
+      }
+
+      // allocation and deallocation must agree on the layout, so both derive it from the count
+      static std::pair<std::size_t,std::size_t> layout(std::size_t count) {
+         if (!is_huge(count)) { return std::make_pair(count * sizeof(T), Alignment); }
+
+         auto huge_alignment = std::max(Alignment, alignment::HugePage);
+         return std::make_pair(vm::round_up(count * sizeof(T), alignment::HugePage), huge_alignment);
+      }
+
+   public:
+      using value_type = T;
+      static constexpr std::size_t alignment_size = Alignment;
+
+      template <typename U>
+      struct rebind { using other = AlignedAllocator<U, Alignment, HugePageThreshold>; };
+
+      AlignedAllocator() noexcept {}
+      template <typename U>
+      AlignedAllocator(const AlignedAllocator<U, Alignment, HugePageThreshold> &) noexcept {}
+
+      T *allocate(std::size_t count) {
+         auto block = layout(count);
+         auto ptr = ::operator new(block.first, std::align_val_t(block.second));
+
+         if (is_huge(count)) { vm::advise_huge_pages(ptr, block.first); }
+
+         return static_cast<T *>(ptr);
+      }
+
+      void deallocate(T *ptr, std::size_t count) {
+         auto block = layout(count);
+         ::operator delete(ptr, block.first, std::align_val_t(block.second));
+      }
+   };
+
+   template <typename T, typename U, std::size_t Alignment, std::size_t Threshold>
+   bool operator==(const AlignedAllocator<T, Alignment, Threshold> &, const AlignedAllocator<U, Alignment, Threshold> &) { return true; }
+
+   template <typename T, typename U, std::size_t Alignment, std::size_t Threshold>
+   bool operator!=(const AlignedAllocator<T, Alignment, Threshold> &, const AlignedAllocator<U, Alignment, Threshold> &) { return false; }
+}
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef __PARFAIT_APPEND_H
+#define __PARFAIT_APPEND_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <parfait/array.hpp>
+
+namespace parfait
+{
+   // an append-only array that many threads can push into at once. producers reserve slots
+   // with a single fetch_add, copy into them and flag them ready, without locking or waiting
+   // on each other. storage grows in segments that double in size, so earlier records never
+   // move and pointers to them stay good. readers only see the longest run of ready records
+   // from the start, so a snapshot never has holes in it.
+   template <typename T, typename Allocator=std::allocator<T>>
+   class AppendBuffer
+   {
+      static_assert(std::is_same<T,typename Allocator::value_type>::value,
+                    "AppendBuffer type and allocator value type must be the same.");
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "AppendBuffer can only hold trivially copyable records.");
+
+   public:
+      static constexpr std::size_t FirstSegment = 1024;
+      static constexpr std::size_t MaxSegments = 40;
+
+   protected:
+      struct Segment
+      {
+         AllocatedMemory<Allocator> memory;
+         AllocatedMemory<> ready;
+         T *data;
+         std::uint8_t *flags;
+
+         // every slot is written before it's flagged, so only the flags need zeroing
+         Segment(std::size_t capacity) : memory(capacity, FillPolicy::WipeOnFree), ready(capacity, FillPolicy::ZeroOnAllocate) {
+            this->data = this->memory.ptr();
+            this->flags = this->ready.ptr();
+         }
+      };
+
+      std::array<std::atomic<Segment *>, MaxSegments> segment_table;
+      std::atomic<std::size_t> reserved;
+      // everything below this is known to be ready. readers move it forward lazily.
+      mutable std::atomic<std::size_t> committed;
+
+      static inline std::size_t segment_capacity(std::size_t segment) { return FirstSegment << segment; }
+      static inline std::size_t segment_base(std::size_t segment) { return FirstSegment * ((static_cast<std::size_t>(1) << segment) - 1); }
+
+      // segment k holds FirstSegment << k records starting at FirstSegment * (2^k - 1)
+      static inline std::size_t segment_of(std::size_t index) {
+         std::size_t segment = 0;
+
+         for (auto scaled=index/FirstSegment+1; scaled > 1; scaled >>= 1)
+            ++segment;
+
+         return segment;
+      }
+
+      // whoever reaches a missing segment first installs it, anyone racing them throws
+      // their copy away
+      Segment *segment(std::size_t index) {
+         auto existing = this->segment_table[index].load(std::memory_order_acquire);
+         if (existing != nullptr) { return existing; }
+
+         auto created = new Segment(segment_capacity(index));
+
+         if (!this->segment_table[index].compare_exchange_strong(existing, created, std::memory_order_acq_rel))
+         {
+            delete created;
+            return existing;
+         }
+
+         return created;
+      }
+
+      // walk the ready flags past the last known prefix and publish how far they reach
+      std::size_t advance() const {
+         auto known = this->committed.load(std::memory_order_acquire);
+         auto limit = this->reserved.load(std::memory_order_acquire);
+         auto index = known;
+
+         while (index < limit)
+         {
+            auto segment_index = segment_of(index);
+            auto segment = this->segment_table[segment_index].load(std::memory_order_acquire);
+
+            if (segment == nullptr) { break; }
+
+            auto end = std::min(limit, segment_base(segment_index+1));
+            auto offset = index - segment_base(segment_index);
+
+            while (index < end && AtomicRef<std::uint8_t>(segment->flags[offset]).load(std::memory_order_acquire) != 0)
+            {
+               ++index;
+               ++offset;
+            }
+
+            if (index < end) { break; }
+         }
+
+         // someone else may have got further in the meantime, never move backwards
+         while (index > known && !this->committed.compare_exchange_weak(known, index, std::memory_order_acq_rel)) {}
+
+         return std::max(index, known);
+      }
+
+   public:
+      using BaseType = T;
+
+      AppendBuffer() : reserved(0), committed(0) {
+         for (auto &entry : this->segment_table)
+            entry.store(nullptr, std::memory_order_relaxed);
+      }
+      AppendBuffer(const AppendBuffer &) = delete;
+      ~AppendBuffer() {
+         for (auto &entry : this->segment_table)
+            delete entry.load(std::memory_order_acquire);
+      }
+
+      AppendBuffer &operator=(const AppendBuffer &) = delete;
+
+      // the number of records visible to readers
+      inline std::size_t size() const { return this->advance(); }
+      inline bool is_empty() const { return this->size() == 0; }
+
+      // appends count records and returns the index of the first one. safe to call from
+      // any number of threads at once. if a segment can't be allocated the reserved slots
+      // are never flagged, and readers stop short of them.
+      std::size_t append(const T *ptr, std::size_t count) {
+         if (count == 0) { throw exception::ZeroSize(); }
+
+         auto start = this->reserved.fetch_add(count, std::memory_order_relaxed);
+         auto end = start + count;
+
+         if (end > segment_base(MaxSegments)) { throw exception::OutOfBounds(end, segment_base(MaxSegments)); }
+
+         for (auto index=start; index < end;)
+         {
+            auto segment_index = segment_of(index);
+            auto segment = this->segment(segment_index);
+            auto offset = index - segment_base(segment_index);
+            auto run = std::min(end - index, segment_capacity(segment_index) - offset);
+
+            std::memcpy(segment->data+offset, ptr+(index-start), run*sizeof(T));
+
+            // one fence orders the copy before every flag in the run
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (std::size_t i=0; i<run; ++i)
+               AtomicRef<std::uint8_t>(segment->flags[offset+i]).store(1, std::memory_order_relaxed);
+
+            index += run;
+         }
+
+         return start;
+      }
+
+      std::size_t append(const T &ref) {
+         return this->append(&ref, 1);
+      }
+
+      std::size_t push_back(const T &value) {
+         return this->append(&value, 1);
+      }
+
+      const T &operator[](std::size_t index) const {
+         if (index >= this->size()) { throw exception::OutOfBounds(index, this->size()); }
+
+         auto segment_index = segment_of(index);
+         auto segment = this->segment_table[segment_index].load(std::memory_order_acquire);
+
+         return segment->data[index - segment_base(segment_index)];
+      }
+
+      // the published records as one span per segment, without copying. the spans stay
+      // valid for the life of the buffer.
+      std::vector<Span<const T>> segments() const {
+         std::vector<Span<const T>> result;
+         auto count = this->size();
+
+         for (std::size_t segment_index=0; segment_base(segment_index) < count; ++segment_index)
+         {
+            auto segment = this->segment_table[segment_index].load(std::memory_order_acquire);
+            auto used = std::min(count - segment_base(segment_index), segment_capacity(segment_index));
+            const auto &memory = segment->memory;
+
+            result.push_back(memory.span().subspan(0, used));
+         }
+
+         return result;
+      }
+
+      // a contiguous copy of everything published so far
+      Array<T, Allocator> snapshot() const {
+         Array<T, Allocator> result;
+         auto count = this->size();
+
+         if (count == 0) { return result; }
+
+         result.allocate(count);
+
+         for (std::size_t segment_index=0; segment_base(segment_index) < count; ++segment_index)
+         {
+            auto segment = this->segment_table[segment_index].load(std::memory_order_acquire);
+            auto base = segment_base(segment_index);
+            auto used = std::min(count - base, segment_capacity(segment_index));
+
+            std::memcpy(result.ptr(base), segment->data, used*sizeof(T));
+         }
+
+         return result;
+      }
+   };
+}
+
+#endif
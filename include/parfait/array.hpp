@@ -41,14 +41,27 @@ namespace parfait
       T& operator[](std::size_t offset) { return *this->ptr(offset); }
       const T& operator[](std::size_t offset) const { return *this->ptr(offset); }
 
+      // build straight from the element pointer rather than going through a registered
+      // intermediate subsection that would be declared and destroyed immediately. the view
+      // is still declared as our child, so it goes invalid along with us.
       Array subsection(std::size_t offset, std::size_t size) {
-         auto subsection = TransparentMemory::subsection(offset, size);
-         return Array(subsection.ptr(), size);
+         if (offset+size > this->size()) { throw exception::InsufficientSize(offset+size, this->size()); }
+
+         Memory::Domain::Scope scope(this->manager());
+         Array result(this->ptr(offset), size);
+         this->manager().declare_child(this, &result);
+
+         return result;
       }
 
       const Array subsection(std::size_t offset, std::size_t size) const {
-         auto subsection = TransparentMemory::subsection(offset, size);
-         return Array(subsection.ptr(), size);
+         if (offset+size > this->size()) { throw exception::InsufficientSize(offset+size, this->size()); }
+
+         Memory::Domain::Scope scope(this->manager());
+         Array result(this->ptr(offset), size);
+         this->manager().declare_child(this, &result);
+
+         return result;
       }
 
       void start_with(const T* pointer, std::size_t size) {
@@ -104,10 +117,127 @@ namespace parfait
          return this->contains(&ref);
       }
 
+      T atomic_load(std::size_t index, std::memory_order order=std::memory_order_seq_cst) const {
+         return Memory::atomic_load<T>(index*sizeof(T), order);
+      }
+
+      void atomic_load(std::size_t index, T *dest, std::size_t count, std::memory_order order=std::memory_order_seq_cst) const {
+         Memory::atomic_load<T>(index*sizeof(T), dest, count, order);
+      }
+
+      void atomic_store(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_store<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_store(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_store<T>(index*sizeof(T), values, count, order);
+      }
+
+      T atomic_exchange(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_exchange<T>(index*sizeof(T), value, order);
+      }
+
+      bool atomic_compare_exchange(std::size_t index, T& expected, const T& desired, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_compare_exchange<T>(index*sizeof(T), expected, desired, order);
+      }
+
+      T atomic_fetch_add(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_fetch_add<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_fetch_add(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_fetch_add<T>(index*sizeof(T), values, count, order);
+      }
+
+      T atomic_fetch_sub(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_fetch_sub<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_fetch_sub(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_fetch_sub<T>(index*sizeof(T), values, count, order);
+      }
+
+      T atomic_fetch_and(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_fetch_and<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_fetch_and(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_fetch_and<T>(index*sizeof(T), values, count, order);
+      }
+
+      T atomic_fetch_or(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_fetch_or<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_fetch_or(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_fetch_or<T>(index*sizeof(T), values, count, order);
+      }
+
+      T atomic_fetch_xor(std::size_t index, const T& value, std::memory_order order=std::memory_order_seq_cst) {
+         return Memory::atomic_fetch_xor<T>(index*sizeof(T), value, order);
+      }
+
+      void atomic_fetch_xor(std::size_t index, const T* values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         Memory::atomic_fetch_xor<T>(index*sizeof(T), values, count, order);
+      }
+
+      bool operator==(const Array &other) const { return this->equals(other); }
+      bool operator!=(const Array &other) const { return !this->equals(other); }
+
+      // returns the index of the first differing element, or nullopt if the arrays are identical.
+      // if one array is a prefix of the other, the size of the shorter array is returned.
+      std::optional<std::size_t> mismatch(const Array &other) const {
+         auto common = std::min(this->size(), other.size());
+         std::optional<std::size_t> result = std::nullopt;
+
+         if constexpr (std::has_unique_object_representations<T>::value)
+         {
+            auto byte_offset = Memory::mismatch(0, other, 0, common*sizeof(T));
+            if (byte_offset.has_value()) { result = *byte_offset / sizeof(T); }
+         }
+         else if (common > 0)
+         {
+            // padding or non-bitwise equality (e.g., floats), compare with the element's operator
+            auto left = this->ptr();
+            auto right = other.ptr();
+
+            this->lock_with(other);
+            auto pair = std::mismatch(left, left+common, right);
+            this->unlock_with(other);
+
+            if (pair.first != left+common) { result = static_cast<std::size_t>(pair.first - left); }
+         }
+
+         if (result.has_value() || this->size() == other.size()) { return result; }
+
+         return common;
+      }
+
+      bool equals(const Array &other) const {
+         return this->size() == other.size() && !this->mismatch(other).has_value();
+      }
+
+      int compare(const Array &other) const {
+         auto index = this->mismatch(other);
+
+         if (!index.has_value()) { return 0; }
+         if (*index == this->size()) { return -1; }
+         if (*index == other.size()) { return 1; }
+
+         return ((*this)[*index] < other[*index]) ? -1 : 1;
+      }
+
       std::pair<Array,Array> split_at(std::size_t midpoint) const {
-         auto pair = TransparentMemory::split_at(midpoint);
-         return std::make_pair(Array(pair.first.ptr(), pair.first.size()),
-                               Array(pair.second.ptr(), pair.second.size()));
+         if (midpoint >= this->size()) { throw exception::OutOfBounds(midpoint, this->size()); }
+
+         Memory::Domain::Scope scope(this->manager());
+         Array left(this->ptr(), midpoint);
+         Array right(this->ptr(midpoint), this->size()-midpoint);
+
+         this->manager().declare_child(this, &left);
+         this->manager().declare_child(this, &right);
+
+         return std::make_pair(left, right);
       }
 
       void load_data(const T *ptr, std::size_t size)
@@ -148,8 +278,13 @@ namespace parfait
       }
 
       Array split_off(std::size_t midpoint) {
-         auto split_off = TransparentMemory::split_off(midpoint);
-         return Array(split_off.ptr(), split_off.size(), true);
+         if (!this->is_allocated()) { throw exception::NotAllocated(); }
+         if (midpoint >= this->size()) { throw exception::OutOfBounds(midpoint, this->size()); }
+
+         Array result(this->ptr(midpoint), this->size() - midpoint, true);
+         this->reallocate(midpoint);
+
+         return result;
       }
 
       std::vector<T> to_vec(void) const {
@@ -171,14 +306,17 @@ namespace parfait
       void swap(std::size_t left, std::size_t right) {
          if (left == right) return;
 
+         this->prepare_write();
          std::swap((*this)[left], (*this)[right]);
       }
 
       void reverse() {
          if (this->size() == 0) { return; }
 
+         this->prepare_write();
+
          for (std::size_t i=0; i<this->size()/2; ++i)
-            this->swap(i, this->size()-i-1);
+            std::swap((*this)[i], (*this)[this->size()-i-1]);
       }
 
       void push_front(const T& value) {
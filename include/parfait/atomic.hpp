@@ -0,0 +1,52 @@
+#ifndef __PARFAIT_ATOMIC_H
+#define __PARFAIT_ATOMIC_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace parfait
+{
+#if defined(__cpp_lib_atomic_ref)
+   template <typename T>
+   using AtomicRef = std::atomic_ref<T>;
+#else
+   // a stand-in for C++20's std::atomic_ref. a lock-free std::atomic<T> has the same size and
+   // representation as T on the compilers we build with, so a suitably aligned T can be
+   // operated on through one.
+   template <typename T>
+   class AtomicRef
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "AtomicRef requires a trivially copyable type.");
+      static_assert(sizeof(std::atomic<T>) == sizeof(T), "std::atomic<T> must have the same size as T.");
+
+      std::atomic<T> *pointer;
+
+   public:
+      using value_type = T;
+      static constexpr bool is_always_lock_free = std::atomic<T>::is_always_lock_free;
+      static constexpr std::size_t required_alignment = alignof(std::atomic<T>);
+
+      explicit AtomicRef(T &ref) : pointer(reinterpret_cast<std::atomic<T> *>(&ref)) {}
+
+      T load(std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->load(order); }
+      void store(T value, std::memory_order order=std::memory_order_seq_cst) const { this->pointer->store(value, order); }
+      T exchange(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->exchange(value, order); }
+
+      bool compare_exchange_weak(T &expected, T desired, std::memory_order order=std::memory_order_seq_cst) const {
+         return this->pointer->compare_exchange_weak(expected, desired, order);
+      }
+      bool compare_exchange_strong(T &expected, T desired, std::memory_order order=std::memory_order_seq_cst) const {
+         return this->pointer->compare_exchange_strong(expected, desired, order);
+      }
+
+      T fetch_add(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->fetch_add(value, order); }
+      T fetch_sub(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->fetch_sub(value, order); }
+      T fetch_and(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->fetch_and(value, order); }
+      T fetch_or(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->fetch_or(value, order); }
+      T fetch_xor(T value, std::memory_order order=std::memory_order_seq_cst) const { return this->pointer->fetch_xor(value, order); }
+   };
+#endif
+}
+
+#endif
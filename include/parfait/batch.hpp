@@ -0,0 +1,255 @@
+#ifndef __PARFAIT_BATCH_H
+#define __PARFAIT_BATCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+#include <parfait/exception.hpp>
+
+namespace parfait
+{
+   // a set of writes, inserts and erases recorded against a buffer and applied to it in one
+   // go with AllocatedMemory::apply. offsets count elements of T, like the buffer's own edit
+   // methods, and always refer to the buffer as it was before the batch: edits don't shift
+   // each other. where writes overlap, the later one wins. erased bytes are gone even if
+   // something wrote to them, and inserts at the same offset keep the order they were made in.
+   template <typename T=std::uint8_t>
+   class WriteBatch
+   {
+   public:
+      enum class EditType
+      {
+         Write,
+         Insert,
+         Erase
+      };
+
+      // byte offsets and sizes. staged edits carry their data in the batch's own storage.
+      struct Edit
+      {
+         EditType type;
+         std::size_t offset;
+         std::size_t size;
+         std::size_t staged;
+
+         Edit(EditType type, std::size_t offset, std::size_t size, std::size_t staged=0)
+            : type(type), offset(offset), size(size), staged(staged) {}
+      };
+
+      // one contiguous run of the result, copied from either the old contents or the
+      // batch's staged data
+      struct Piece
+      {
+         std::size_t dest;
+         bool staged;
+         std::size_t source;
+         std::size_t size;
+
+         Piece(std::size_t dest, bool staged, std::size_t source, std::size_t size)
+            : dest(dest), staged(staged), source(source), size(size) {}
+      };
+
+      struct Layout
+      {
+         std::size_t size;
+         bool in_place;
+         std::vector<Piece> pieces;
+      };
+
+   protected:
+      std::vector<Edit> edits;
+      std::vector<std::uint8_t> staging;
+
+      template <typename U>
+      std::size_t byte_size(std::size_t size) const {
+         std::size_t typesize = 1;
+         if constexpr (!std::is_same<U,void>::value) { typesize *= sizeof(U); }
+
+         auto result = typesize * size;
+         if (result % sizeof(T) != 0) { throw exception::BadAlignment(result, sizeof(T)); }
+
+         return result;
+      }
+
+      std::size_t stage(const void *ptr, std::size_t size) {
+         if (ptr == nullptr) { throw exception::NullPointer(); }
+
+         auto offset = this->staging.size();
+         auto bytes = reinterpret_cast<const std::uint8_t *>(ptr);
+
+         this->staging.insert(this->staging.end(), bytes, bytes+size);
+
+         return offset;
+      }
+
+      static void emit(std::vector<Piece> &pieces, std::size_t dest, bool staged, std::size_t source, std::size_t size) {
+         if (size == 0) { return; }
+
+         if (pieces.size() > 0)
+         {
+            auto &last = pieces.back();
+
+            if (last.staged == staged && last.dest+last.size == dest && last.source+last.size == source)
+            {
+               last.size += size;
+               return;
+            }
+         }
+
+         pieces.push_back(Piece(dest, staged, source, size));
+      }
+
+   public:
+      WriteBatch() {}
+
+      inline std::size_t size() const { return this->edits.size(); }
+      inline bool is_empty() const { return this->edits.size() == 0; }
+      inline const std::vector<Edit> &get_edits() const { return this->edits; }
+      inline const std::uint8_t *staged_data() const { return this->staging.data(); }
+
+      void clear() {
+         this->edits.clear();
+         this->staging.clear();
+      }
+
+      template <typename U>
+      void write(std::size_t offset, const U* ptr, std::size_t size) {
+         auto fixed_size = this->byte_size<U>(size);
+         if (fixed_size == 0) { return; }
+
+         auto staged = this->stage(ptr, fixed_size);
+         this->edits.push_back(Edit(EditType::Write, offset * sizeof(T), fixed_size, staged));
+      }
+
+      template <typename U>
+      void write(std::size_t offset, const U* ptr) {
+         this->write<U>(offset, ptr, 1);
+      }
+
+      template <typename U>
+      void write(std::size_t offset, const U& ref) {
+         this->write<U>(offset, &ref);
+      }
+
+      template <typename U>
+      void insert(std::size_t offset, const U* ptr, std::size_t size) {
+         auto fixed_size = this->byte_size<U>(size);
+         if (fixed_size == 0) { return; }
+
+         auto staged = this->stage(ptr, fixed_size);
+         this->edits.push_back(Edit(EditType::Insert, offset * sizeof(T), fixed_size, staged));
+      }
+
+      template <typename U>
+      void insert(std::size_t offset, const U* ptr) {
+         this->insert<U>(offset, ptr, 1);
+      }
+
+      template <typename U>
+      void insert(std::size_t offset, const U& ref) {
+         this->insert<U>(offset, &ref);
+      }
+
+      void erase(std::size_t offset, std::size_t size) {
+         if (size == 0) { return; }
+         this->edits.push_back(Edit(EditType::Erase, offset * sizeof(T), size * sizeof(T)));
+      }
+
+      // check every edit against a buffer of the given byte size and work out the result as
+      // a sorted, coalesced list of pieces. nothing is touched if an edit is out of bounds.
+      Layout layout(std::size_t size) const {
+         std::vector<std::pair<std::size_t,std::size_t>> erased;
+         std::vector<const Edit *> inserts;
+         std::map<std::size_t, Piece> written;
+         std::vector<std::size_t> boundaries = { 0, size };
+
+         for (auto &edit : this->edits)
+         {
+            auto end = (edit.type == EditType::Insert) ? edit.offset : edit.offset+edit.size;
+            if (end > size) { throw exception::OutOfBounds(end, size); }
+
+            boundaries.push_back(edit.offset);
+            if (edit.type != EditType::Insert) { boundaries.push_back(end); }
+
+            if (edit.type == EditType::Insert) { inserts.push_back(&edit); }
+            else if (edit.type == EditType::Erase) { erased.push_back(std::make_pair(edit.offset, end)); }
+            else
+            {
+               // trim whatever this write covers out of the earlier ones. a write straddling
+               // ours keeps its head and tail.
+               auto it = written.lower_bound(edit.offset);
+               if (it != written.begin() && std::prev(it)->second.dest+std::prev(it)->second.size > edit.offset) { --it; }
+
+               while (it != written.end() && it->first < end)
+               {
+                  auto piece = it->second;
+                  auto piece_end = piece.dest+piece.size;
+
+                  it = written.erase(it);
+
+                  if (piece.dest < edit.offset)
+                     written.emplace(piece.dest, Piece(piece.dest, true, piece.source, edit.offset-piece.dest));
+
+                  if (piece_end > end)
+                     written.emplace(end, Piece(end, true, piece.source+(end-piece.dest), piece_end-end));
+               }
+
+               written.emplace(edit.offset, Piece(edit.offset, true, edit.staged, edit.size));
+            }
+         }
+
+         std::sort(erased.begin(), erased.end());
+         std::stable_sort(inserts.begin(), inserts.end(), [](const Edit *left, const Edit *right) { return left->offset < right->offset; });
+         std::sort(boundaries.begin(), boundaries.end());
+         boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+         Layout result;
+         result.in_place = inserts.size() == 0 && erased.size() == 0;
+
+         // walk the old contents from boundary to boundary. writes and erases both start and
+         // end on boundaries, so each stretch between two is entirely one kind of thing.
+         auto next_insert = inserts.begin();
+         auto next_erase = erased.begin();
+         auto next_write = written.begin();
+         std::size_t dest = 0;
+
+         for (std::size_t i=0; i<boundaries.size(); ++i)
+         {
+            auto low = boundaries[i];
+
+            for (; next_insert != inserts.end() && (*next_insert)->offset == low; ++next_insert)
+            {
+               emit(result.pieces, dest, true, (*next_insert)->staged, (*next_insert)->size);
+               dest += (*next_insert)->size;
+            }
+
+            if (i+1 == boundaries.size()) { break; }
+
+            auto high = boundaries[i+1];
+
+            while (next_erase != erased.end() && next_erase->second <= low) { ++next_erase; }
+            while (next_write != written.end() && next_write->second.dest+next_write->second.size <= low) { ++next_write; }
+
+            if (next_erase != erased.end() && next_erase->first <= low) { continue; }
+
+            if (next_write != written.end() && next_write->first <= low)
+               emit(result.pieces, dest, true, next_write->second.source+(low-next_write->first), high-low);
+            else if (!result.in_place)
+               emit(result.pieces, dest, false, low, high-low);
+
+            dest += high-low;
+         }
+
+         result.size = dest;
+
+         return result;
+      }
+   };
+}
+
+#endif
@@ -91,6 +91,90 @@ namespace exception
       }
    };
 
+   class ReservationExceeded : public Exception
+   {
+   public:
+      std::size_t given;
+      std::size_t reserved;
+
+      ReservationExceeded(std::size_t given, std::size_t reserved) : given(given), reserved(reserved), Exception() {
+         std::stringstream stream;
+
+         stream << "Reservation exceeded: the requested size is "
+                << this->given
+                << ", but only "
+                << this->reserved
+                << " bytes of address space were reserved";
+
+         this->error = stream.str();
+      }
+   };
+
+   class MappingFailure : public Exception
+   {
+   public:
+      std::size_t size;
+
+      MappingFailure(std::size_t size) : size(size), Exception() {
+         std::stringstream stream;
+
+         stream << "Mapping failure: the operating system refused to reserve, commit or release "
+                << this->size
+                << " bytes of virtual memory";
+
+         this->error = stream.str();
+      }
+   };
+
+   class AffinityFailure : public Exception
+   {
+   public:
+      std::size_t cpu;
+
+      AffinityFailure(std::size_t cpu) : cpu(cpu), Exception() {
+         std::stringstream stream;
+
+         stream << "Affinity failure: the operating system refused to pin a thread to cpu "
+                << this->cpu;
+
+         this->error = stream.str();
+      }
+   };
+
+   class Pinned : public Exception
+   {
+   public:
+      const void *ptr;
+      std::size_t size;
+
+      Pinned(const void *ptr, std::size_t size) : ptr(ptr), size(size), Exception() {
+         std::stringstream stream;
+
+         stream << "Pinned: the memory at "
+                << std::hex << std::showbase << this->ptr
+                << " with the size " << std::dec << std::noshowbase << this->size
+                << " is pinned and can't be invalidated, moved or resized until its pins are released";
+
+         this->error = stream.str();
+      }
+   };
+
+   class DomainInUse : public Exception
+   {
+   public:
+      std::size_t pins;
+
+      DomainInUse(std::size_t pins) : pins(pins), Exception() {
+         std::stringstream stream;
+
+         stream << "Domain in use: the domain can't be torn down while "
+                << this->pins
+                << " pins are held in it.";
+
+         this->error = stream.str();
+      }
+   };
+
    class ZeroSize : public Exception
    {
    public:
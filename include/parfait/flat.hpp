@@ -0,0 +1,484 @@
+#ifndef __PARFAIT_FLAT_H
+#define __PARFAIT_FLAT_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+namespace parfait
+{
+   // a small set kept in insertion order in a flat array. the first few items live inline,
+   // which covers almost every object and child list the manager keeps, so walking one
+   // doesn't chase pointers through tree nodes.
+   template <typename T, std::size_t Inline=4>
+   class FlatSet
+   {
+      std::size_t count;
+      std::array<T, Inline> inline_items;
+      std::vector<T> spilled;
+
+      inline T *data() { return (this->count > Inline) ? this->spilled.data() : this->inline_items.data(); }
+      inline const T *data() const { return (this->count > Inline) ? this->spilled.data() : this->inline_items.data(); }
+
+      void append(const T &value) {
+         if (this->count < Inline) { this->inline_items[this->count] = value; }
+         else
+         {
+            if (this->count == Inline) { this->spilled.assign(this->inline_items.begin(), this->inline_items.end()); }
+            this->spilled.push_back(value);
+         }
+
+         ++this->count;
+      }
+
+   public:
+      FlatSet() : count(0) {}
+
+      inline std::size_t size() const { return this->count; }
+      inline bool empty() const { return this->count == 0; }
+      inline const T *begin() const { return this->data(); }
+      inline const T *end() const { return this->data()+this->count; }
+
+      const T *find(const T &value) const {
+         return std::find(this->begin(), this->end(), value);
+      }
+
+      bool insert(const T &value) {
+         if (this->find(value) != this->end()) { return false; }
+
+         this->append(value);
+
+         return true;
+      }
+
+      // insert every value not already present, checking against a sorted copy rather than
+      // scanning the set once per value. new values keep the order they come in.
+      template <typename Iterator>
+      std::size_t insert(Iterator first, Iterator last) {
+         std::vector<T> present(this->begin(), this->end());
+         std::vector<T> incoming(first, last);
+         std::vector<T> sorted_incoming = incoming;
+         std::vector<bool> added;
+
+         std::sort(present.begin(), present.end());
+         std::sort(sorted_incoming.begin(), sorted_incoming.end());
+         added.resize(sorted_incoming.size(), false);
+
+         std::size_t inserted = 0;
+
+         for (auto &value : incoming)
+         {
+            if (std::binary_search(present.begin(), present.end(), value)) { continue; }
+
+            auto index = std::lower_bound(sorted_incoming.begin(), sorted_incoming.end(), value) - sorted_incoming.begin();
+            if (added[index]) { continue; }
+
+            added[index] = true;
+            this->append(value);
+            ++inserted;
+         }
+
+         return inserted;
+      }
+
+      std::size_t erase(const T &value) {
+         auto items = this->data();
+         auto found = std::find(items, items+this->count, value);
+
+         if (found == items+this->count) { return 0; }
+
+         std::copy(found+1, items+this->count, found);
+         --this->count;
+
+         if (this->count == Inline)
+         {
+            std::copy(this->spilled.begin(), this->spilled.begin()+Inline, this->inline_items.begin());
+            this->spilled.clear();
+         }
+         else if (this->count > Inline) { this->spilled.pop_back(); }
+
+         return 1;
+      }
+
+      // erase every value in the range with one pass over the set
+      template <typename Iterator>
+      std::size_t erase(Iterator first, Iterator last) {
+         std::vector<T> erasing(first, last);
+         std::sort(erasing.begin(), erasing.end());
+
+         std::vector<T> kept;
+         kept.reserve(this->count);
+
+         for (auto &value : *this)
+            if (!std::binary_search(erasing.begin(), erasing.end(), value)) { kept.push_back(value); }
+
+         auto erased = this->count - kept.size();
+
+         if (erased == 0) { return 0; }
+
+         this->clear();
+
+         for (auto &value : kept)
+            this->append(value);
+
+         return erased;
+      }
+
+      void clear() {
+         this->count = 0;
+         this->spilled.clear();
+      }
+   };
+
+   // a recycling store for records kept by slot number. records never move once made, and
+   // released ones are reset in place and handed out again before anything new is created,
+   // so a steady stream of acquire/release pairs doesn't allocate. T clears itself with
+   // reset(), keeping whatever storage it already has.
+   template <typename T>
+   class SlotPool
+   {
+      std::deque<T> slots;
+      std::vector<std::size_t> free_slots;
+      std::size_t created;
+      std::size_t reused;
+
+   public:
+      SlotPool() : created(0), reused(0) {}
+
+      inline T &operator[](std::size_t slot) { return this->slots[slot]; }
+      inline const T &operator[](std::size_t slot) const { return this->slots[slot]; }
+
+      inline std::size_t size() const { return this->slots.size() - this->free_slots.size(); }
+      inline std::size_t allocations() const { return this->created; }
+      inline std::size_t reuses() const { return this->reused; }
+
+      std::size_t acquire() {
+         if (this->free_slots.size() > 0)
+         {
+            auto slot = this->free_slots.back();
+            this->free_slots.pop_back();
+            ++this->reused;
+
+            return slot;
+         }
+
+         this->slots.emplace_back();
+         ++this->created;
+
+         return this->slots.size()-1;
+      }
+
+      void release(std::size_t slot) {
+         this->slots[slot].reset();
+         this->free_slots.push_back(slot);
+      }
+
+      void clear() {
+         this->free_slots.clear();
+
+         for (std::size_t slot=0; slot<this->slots.size(); ++slot)
+            this->release(slot);
+      }
+   };
+
+   // the set of intervals the manager knows about, laid out for the "is anything covering
+   // this range" query every pointer access makes. intervals are kept sorted in blocks of
+   // contiguous entries, each carrying the furthest any entry up to it reaches. a lookup is
+   // a binary search over the blocks' first bounds followed by one inside a single block,
+   // touching a handful of cache lines rather than a path of tree nodes. updates shift
+   // within one block and split it when it gets too big. each interval carries a slot
+   // number for whoever keeps data alongside it. emptied blocks are kept for reuse, so once
+   // the index has grown, inserting and erasing don't allocate.
+   template <typename IntervalType, std::size_t BlockSize=128>
+   class FlatIntervalIndex
+   {
+   public:
+      using ValueType = decltype(IntervalType().low);
+
+   protected:
+      struct Entry
+      {
+         IntervalType interval;
+         // the highest bound of any entry in the block up to and including this one
+         ValueType reach;
+         std::size_t slot;
+
+         Entry(IntervalType interval, std::size_t slot) : interval(interval), reach(interval.high), slot(slot) {}
+      };
+
+      using Block = std::vector<Entry>;
+
+      std::vector<Block> blocks;
+      std::vector<Block> spare_blocks;
+      std::vector<IntervalType> block_first;
+      // the highest bound of any entry in the blocks up to and including this one. only
+      // good below reach_valid, updates push that back and lookups catch it up.
+      mutable std::vector<ValueType> block_reach;
+      mutable std::size_t reach_valid;
+      std::size_t count;
+      std::size_t block_allocations;
+
+      static inline bool less(const IntervalType &left, const IntervalType &right) {
+         return left.low < right.low || (left.low == right.low && left.high < right.high);
+      }
+
+      // the block that holds or would hold the interval
+      std::size_t find_block(const IntervalType &interval) const {
+         auto found = std::upper_bound(this->block_first.begin(), this->block_first.end(), interval,
+                                       [](const IntervalType &key, const IntervalType &first) { return less(key, first); });
+         if (found == this->block_first.begin()) { return 0; }
+
+         return static_cast<std::size_t>(found - this->block_first.begin()) - 1;
+      }
+
+      // the last block starting at or before the bound
+      std::size_t find_block(ValueType low) const {
+         auto found = std::upper_bound(this->block_first.begin(), this->block_first.end(), low,
+                                       [](ValueType key, const IntervalType &first) { return key < first.low; });
+
+         return static_cast<std::size_t>(found - this->block_first.begin()) - 1;
+      }
+
+      Block new_block() {
+         if (this->spare_blocks.size() > 0)
+         {
+            auto block = std::move(this->spare_blocks.back());
+            this->spare_blocks.pop_back();
+            return block;
+         }
+
+         // room for the most a block holds before it splits, so inserts never reallocate it
+         Block block;
+         block.reserve(BlockSize*2);
+         ++this->block_allocations;
+
+         return block;
+      }
+
+      void retire_block(std::size_t block_index) {
+         this->blocks[block_index].clear();
+         this->spare_blocks.push_back(std::move(this->blocks[block_index]));
+         this->blocks.erase(this->blocks.begin()+block_index);
+         this->block_first.erase(this->block_first.begin()+block_index);
+      }
+
+      typename Block::const_iterator find_entry(const Block &block, const IntervalType &interval) const {
+         auto found = std::lower_bound(block.begin(), block.end(), interval,
+                                       [](const Entry &entry, const IntervalType &key) { return less(entry.interval, key); });
+
+         if (found != block.end() && !(found->interval == interval)) { return block.end(); }
+
+         return found;
+      }
+
+      static void rebuild_reach(Block &block, std::size_t from) {
+         for (auto i=from; i<block.size(); ++i)
+         {
+            auto reach = block[i].interval.high;
+            if (i > 0 && block[i-1].reach > reach) { reach = block[i-1].reach; }
+            block[i].reach = reach;
+         }
+      }
+
+      void invalidate_reach(std::size_t block_index) {
+         this->reach_valid = std::min(this->reach_valid, block_index);
+      }
+
+      void update_reach() const {
+         this->block_reach.resize(this->blocks.size());
+
+         for (auto i=this->reach_valid; i<this->blocks.size(); ++i)
+         {
+            auto reach = this->blocks[i].back().reach;
+            if (i > 0 && this->block_reach[i-1] > reach) { reach = this->block_reach[i-1]; }
+            this->block_reach[i] = reach;
+         }
+
+         this->reach_valid = this->blocks.size();
+      }
+
+   public:
+      FlatIntervalIndex() : reach_valid(0), count(0), block_allocations(0) {}
+
+      inline std::size_t size() const { return this->count; }
+      inline bool empty() const { return this->count == 0; }
+
+      // how many blocks the index has had to allocate, as opposed to reusing emptied ones
+      inline std::size_t allocations() const { return this->block_allocations; }
+
+      void clear() {
+         while (this->blocks.size() > 0)
+            this->retire_block(this->blocks.size()-1);
+
+         this->block_reach.clear();
+         this->reach_valid = 0;
+         this->count = 0;
+      }
+
+      bool has(const IntervalType &interval) const {
+         return this->find(interval) != nullptr;
+      }
+
+      // the slot stored with the interval, or null if it isn't in the index
+      const std::size_t *find(const IntervalType &interval) const {
+         if (this->count == 0) { return nullptr; }
+
+         auto &block = this->blocks[this->find_block(interval)];
+         auto found = this->find_entry(block, interval);
+
+         if (found == block.end()) { return nullptr; }
+
+         return &found->slot;
+      }
+
+      // whether any interval starts at or before low and ends at or after high
+      bool covers(ValueType low, ValueType high) const {
+         if (this->count == 0 || low < this->block_first.front().low) { return false; }
+
+         auto block_index = this->find_block(low);
+         auto &block = this->blocks[block_index];
+         auto found = std::upper_bound(block.begin(), block.end(), low,
+                                       [](ValueType key, const Entry &entry) { return key < entry.interval.low; });
+
+         if (found != block.begin() && std::prev(found)->reach >= high) { return true; }
+         if (block_index == 0) { return false; }
+
+         if (this->reach_valid < block_index) { this->update_reach(); }
+
+         return this->block_reach[block_index-1] >= high;
+      }
+
+      // calls visit(interval, slot) for every interval that starts at or before low and ends
+      // at or after high, walking back only as far as the reach says something might
+      template <typename Visitor>
+      void containing(ValueType low, ValueType high, Visitor visit) const {
+         if (this->count == 0 || low < this->block_first.front().low) { return; }
+         if (this->reach_valid < this->blocks.size()) { this->update_reach(); }
+
+         auto block_index = this->find_block(low);
+         auto &last_block = this->blocks[block_index];
+         auto end = std::upper_bound(last_block.begin(), last_block.end(), low,
+                                     [](ValueType key, const Entry &entry) { return key < entry.interval.low; });
+
+         for (;;)
+         {
+            auto &block = this->blocks[block_index];
+
+            for (auto entry=end; entry != block.begin();)
+            {
+               --entry;
+
+               if (entry->reach < high) { break; }
+               if (entry->interval.high >= high) { visit(entry->interval, entry->slot); }
+            }
+
+            if (block_index == 0 || this->block_reach[block_index-1] < high) { return; }
+
+            --block_index;
+            end = this->blocks[block_index].end();
+         }
+      }
+
+      // calls visit(interval, slot) for every interval sharing any part of [low, high), the
+      // same backwards walk as containing() but stopping once nothing reaches past low
+      template <typename Visitor>
+      void overlapping(ValueType low, ValueType high, Visitor visit) const {
+         if (this->count == 0 || high <= low || high <= this->block_first.front().low) { return; }
+         if (this->reach_valid < this->blocks.size()) { this->update_reach(); }
+
+         auto block_index = this->find_block(high-1);
+         auto &last_block = this->blocks[block_index];
+         auto end = std::upper_bound(last_block.begin(), last_block.end(), high-1,
+                                     [](ValueType key, const Entry &entry) { return key < entry.interval.low; });
+
+         for (;;)
+         {
+            auto &block = this->blocks[block_index];
+
+            for (auto entry=end; entry != block.begin();)
+            {
+               --entry;
+
+               if (entry->reach <= low) { break; }
+               if (entry->interval.high > low) { visit(entry->interval, entry->slot); }
+            }
+
+            if (block_index == 0 || this->block_reach[block_index-1] <= low) { return; }
+
+            --block_index;
+            end = this->blocks[block_index].end();
+         }
+      }
+
+      bool insert(const IntervalType &interval, std::size_t slot=0) {
+         if (this->count == 0)
+         {
+            this->blocks.push_back(this->new_block());
+            this->blocks.back().push_back(Entry(interval, slot));
+            this->block_first.push_back(interval);
+            this->invalidate_reach(0);
+            this->count = 1;
+
+            return true;
+         }
+
+         auto block_index = this->find_block(interval);
+         auto &block = this->blocks[block_index];
+         auto found = std::lower_bound(block.begin(), block.end(), interval,
+                                       [](const Entry &entry, const IntervalType &key) { return less(entry.interval, key); });
+
+         if (found != block.end() && found->interval == interval) { return false; }
+
+         auto position = static_cast<std::size_t>(found - block.begin());
+         block.insert(found, Entry(interval, slot));
+         rebuild_reach(block, position);
+         this->block_first[block_index] = block.front().interval;
+
+         if (block.size() >= BlockSize*2)
+         {
+            auto upper = this->new_block();
+            upper.assign(block.begin()+BlockSize, block.end());
+            block.erase(block.begin()+BlockSize, block.end());
+            rebuild_reach(upper, 0);
+
+            this->block_first.insert(this->block_first.begin()+block_index+1, upper.front().interval);
+            this->blocks.insert(this->blocks.begin()+block_index+1, std::move(upper));
+         }
+
+         this->invalidate_reach(block_index);
+         ++this->count;
+
+         return true;
+      }
+
+      bool erase(const IntervalType &interval) {
+         if (this->count == 0) { return false; }
+
+         auto block_index = this->find_block(interval);
+         auto &block = this->blocks[block_index];
+         auto found = this->find_entry(block, interval);
+
+         if (found == block.end()) { return false; }
+
+         auto position = static_cast<std::size_t>(found - block.begin());
+         block.erase(found);
+
+         if (block.empty()) { this->retire_block(block_index); }
+         else
+         {
+            rebuild_reach(block, position);
+            this->block_first[block_index] = block.front().interval;
+         }
+
+         this->invalidate_reach(block_index);
+         --this->count;
+
+         return true;
+      }
+   };
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __PARFAIT_ITERATOR_H
+#define __PARFAIT_ITERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include <parfait/exception.hpp>
+
+// with PARFAIT_ITERATOR_DEBUG set, iterators carry their bounds and the generation of their
+// region and check them on every dereference. otherwise they're a bare pointer. it changes
+// the iterator's layout, so everything linked together has to agree on it: it comes from
+// the PARFAIT_ITERATOR_DEBUG cmake option, which libparfait exports to its users.
+#if !defined(PARFAIT_ITERATOR_DEBUG)
+#define PARFAIT_ITERATOR_DEBUG 0
+#endif
+
+namespace parfait
+{
+   using Generation = std::atomic<std::uint64_t>;
+
+   template <typename T>
+   class Iterator
+   {
+      template <typename U>
+      friend class Iterator;
+
+   protected:
+      T *current;
+#if PARFAIT_ITERATOR_DEBUG
+      T *first;
+      T *last;
+      const Generation *generation_slot;
+      std::uint64_t generation;
+#endif
+
+      inline void validate() const {
+#if PARFAIT_ITERATOR_DEBUG
+         if (this->current < this->first || this->current >= this->last)
+            throw exception::OutOfBounds(static_cast<std::size_t>(this->current - this->first),
+                                         static_cast<std::size_t>(this->last - this->first));
+
+         if (this->generation_slot != nullptr && this->generation_slot->load(std::memory_order_acquire) != this->generation)
+            throw exception::InvalidPointer(this->first, (this->last - this->first) * sizeof(T));
+#endif
+      }
+
+   public:
+      using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus >= 202002L
+      using iterator_concept = std::contiguous_iterator_tag;
+#endif
+      using value_type = typename std::remove_const<T>::type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T*;
+      using reference = T&;
+
+      Iterator() : current(nullptr)
+#if PARFAIT_ITERATOR_DEBUG
+                 , first(nullptr), last(nullptr), generation_slot(nullptr), generation(0)
+#endif
+      {}
+      Iterator(T *current, T *first, T *last, const Generation *generation_slot, std::uint64_t generation)
+         : current(current)
+#if PARFAIT_ITERATOR_DEBUG
+         , first(first), last(last), generation_slot(generation_slot), generation(generation)
+#endif
+      {}
+
+      template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+      Iterator(const Iterator<U> &other)
+         : current(other.current)
+#if PARFAIT_ITERATOR_DEBUG
+         , first(other.first), last(other.last), generation_slot(other.generation_slot), generation(other.generation)
+#endif
+      {}
+
+      inline T& operator*() const { this->validate(); return *this->current; }
+      inline T* operator->() const { this->validate(); return this->current; }
+      inline T& operator[](difference_type offset) const { return *(*this + offset); }
+
+      inline Iterator& operator++() { ++this->current; return *this; }
+      inline Iterator operator++(int) { auto result = *this; ++this->current; return result; }
+      inline Iterator& operator--() { --this->current; return *this; }
+      inline Iterator operator--(int) { auto result = *this; --this->current; return result; }
+      inline Iterator& operator+=(difference_type offset) { this->current += offset; return *this; }
+      inline Iterator& operator-=(difference_type offset) { this->current -= offset; return *this; }
+      inline Iterator operator+(difference_type offset) const { auto result = *this; result += offset; return result; }
+      inline Iterator operator-(difference_type offset) const { auto result = *this; result -= offset; return result; }
+      inline difference_type operator-(const Iterator &other) const { return this->current - other.current; }
+      friend inline Iterator operator+(difference_type offset, const Iterator &iter) { return iter + offset; }
+
+      inline bool operator==(const Iterator &other) const { return this->current == other.current; }
+      inline bool operator!=(const Iterator &other) const { return this->current != other.current; }
+      inline bool operator<(const Iterator &other) const { return this->current < other.current; }
+      inline bool operator>(const Iterator &other) const { return this->current > other.current; }
+      inline bool operator<=(const Iterator &other) const { return this->current <= other.current; }
+      inline bool operator>=(const Iterator &other) const { return this->current >= other.current; }
+
+      // the raw address, unchecked, for handing to APIs that want a pointer
+      inline T* address() const { return this->current; }
+   };
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef __PARFAIT_KERNEL_H
+#define __PARFAIT_KERNEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARFAIT_KERNEL_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARFAIT_KERNEL_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace parfait
+{
+namespace kernel
+{
+   inline std::size_t count_trailing_zeros(std::uint32_t value) {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, value);
+      return static_cast<std::size_t>(index);
+#else
+      return static_cast<std::size_t>(__builtin_ctz(value));
+#endif
+   }
+
+   // returns the offset of the first byte that differs between the two buffers,
+   // or size if the buffers are identical
+   inline std::size_t mismatch(const std::uint8_t *left, const std::uint8_t *right, std::size_t size) {
+      std::size_t offset = 0;
+
+      if (left == right) { return size; }
+
+#if defined(PARFAIT_KERNEL_AVX2)
+      for (; offset+32 <= size; offset+=32)
+      {
+         auto left_block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&left[offset]));
+         auto right_block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&right[offset]));
+         auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(left_block, right_block)));
+
+         if (mask != 0xFFFFFFFF)
+            return offset + count_trailing_zeros(~mask);
+      }
+#endif
+
+#if defined(PARFAIT_KERNEL_SSE2)
+      for (; offset+16 <= size; offset+=16)
+      {
+         auto left_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&left[offset]));
+         auto right_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&right[offset]));
+         auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(left_block, right_block)));
+
+         if (mask != 0xFFFF)
+            return offset + count_trailing_zeros(~mask & 0xFFFF);
+      }
+#endif
+
+      // no vector unit available (or we're on the tail), compare a word at a time
+      // and fall back to bytes once a word differs
+      for (; offset+sizeof(std::uint64_t) <= size; offset+=sizeof(std::uint64_t))
+      {
+         std::uint64_t left_word, right_word;
+         std::memcpy(&left_word, &left[offset], sizeof(std::uint64_t));
+         std::memcpy(&right_word, &right[offset], sizeof(std::uint64_t));
+
+         if (left_word != right_word) { break; }
+      }
+
+      for (; offset<size; ++offset)
+      {
+         if (left[offset] != right[offset])
+            return offset;
+      }
+
+      return size;
+   }
+
+   // memcmp-style three-way comparison built on the mismatch kernel
+   inline int compare(const std::uint8_t *left, const std::uint8_t *right, std::size_t size) {
+      auto offset = mismatch(left, right, size);
+
+      if (offset == size) { return 0; }
+
+      return (left[offset] < right[offset]) ? -1 : 1;
+   }
+
+   // ranges at least this large bypass the cache with non-temporal stores, since
+   // they would evict everything else on their way through anyway
+   const std::size_t NonTemporalThreshold = 4 * 1024 * 1024;
+
+   inline bool overlaps(const void *left, const void *right, std::size_t size) {
+      auto left_base = reinterpret_cast<std::uintptr_t>(left);
+      auto right_base = reinterpret_cast<std::uintptr_t>(right);
+
+      return left_base < right_base+size && right_base < left_base+size;
+   }
+
+   // copy non-overlapping buffers with non-temporal stores so the destination
+   // doesn't get pulled through the cache
+   inline void stream_copy(std::uint8_t *dest, const std::uint8_t *src, std::size_t size) {
+#if defined(PARFAIT_KERNEL_SSE2)
+      auto head = std::min(size, static_cast<std::size_t>((16 - (reinterpret_cast<std::uintptr_t>(dest) & 0xF)) & 0xF));
+      std::memcpy(dest, src, head);
+
+      std::size_t offset = head;
+
+      for (; offset+64 <= size; offset+=64)
+      {
+         auto block0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[offset]));
+         auto block1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[offset+16]));
+         auto block2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[offset+32]));
+         auto block3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[offset+48]));
+
+         _mm_stream_si128(reinterpret_cast<__m128i *>(&dest[offset]), block0);
+         _mm_stream_si128(reinterpret_cast<__m128i *>(&dest[offset+16]), block1);
+         _mm_stream_si128(reinterpret_cast<__m128i *>(&dest[offset+32]), block2);
+         _mm_stream_si128(reinterpret_cast<__m128i *>(&dest[offset+48]), block3);
+      }
+
+      _mm_sfence();
+      std::memcpy(&dest[offset], &src[offset], size-offset);
+#else
+      std::memcpy(dest, src, size);
+#endif
+   }
+
+   // copy non-overlapping buffers, streaming past the cache for very large ranges
+   inline void copy(std::uint8_t *dest, const std::uint8_t *src, std::size_t size) {
+      if (size >= NonTemporalThreshold) { stream_copy(dest, src, size); }
+      else { std::memcpy(dest, src, size); }
+   }
+
+   // copy buffers that may overlap
+   inline void move(std::uint8_t *dest, const std::uint8_t *src, std::size_t size) {
+      if (dest == src || size == 0) { return; }
+      if (overlaps(dest, src, size)) { std::memmove(dest, src, size); }
+      else { copy(dest, src, size); }
+   }
+
+   // fill the buffer with a repeating pattern. if size isn't a multiple of the pattern
+   // size, the final repetition is truncated.
+   inline void fill(std::uint8_t *dest, std::size_t size, const std::uint8_t *pattern, std::size_t pattern_size) {
+      if (size == 0 || pattern_size == 0) { return; }
+
+      auto streaming = size >= NonTemporalThreshold;
+
+      if (pattern_size == 1 && !streaming) {
+         std::memset(dest, pattern[0], size);
+         return;
+      }
+
+      // seed the front of the buffer, then keep doubling it from itself until we reach
+      // a block big enough to stamp out the rest of the range
+      const std::size_t block_target = 64 * 1024;
+      auto block_size = std::min(pattern_size, size);
+      std::memcpy(dest, pattern, block_size);
+
+      while (block_size < size && block_size < block_target)
+      {
+         auto grow = std::min(block_size, size-block_size);
+         std::memcpy(&dest[block_size], dest, grow);
+         block_size += grow;
+      }
+
+      // the stamp must end on a pattern boundary for the repetition to line up
+      if (block_size < size) { block_size -= block_size % pattern_size; }
+
+      for (auto offset=block_size; offset<size; offset+=block_size)
+      {
+         auto stamp_size = std::min(block_size, size-offset);
+
+         if (streaming) { stream_copy(&dest[offset], dest, stamp_size); }
+         else { std::memcpy(&dest[offset], dest, stamp_size); }
+      }
+   }
+
+   // zero the buffer in a way the compiler can't drop as a dead store, for wiping
+   // memory that's about to be freed
+   inline void secure_zero(void *dest, std::size_t size) {
+      if (size == 0) { return; }
+
+      static void *(*const volatile wipe)(void *, int, std::size_t) = std::memset;
+      wipe(dest, 0, size);
+   }
+
+   // a KMP matcher that can be fed the haystack in pieces, so matches that straddle
+   // non-contiguous chunks are still found. offsets are relative to the first byte fed.
+   class Searcher
+   {
+      const std::uint8_t *needle;
+      std::size_t needle_size;
+      std::vector<std::int64_t> partial_table;
+      std::int64_t needle_index;
+      std::size_t position;
+
+   public:
+      Searcher(const std::uint8_t *needle, std::size_t needle_size)
+         : needle(needle), needle_size(needle_size), partial_table(needle_size+1), needle_index(0), position(0)
+      {
+         if (needle_size == 0) { return; }
+
+         std::size_t table_index = 1;
+         std::int64_t candidate_index = 0;
+         this->partial_table[0] = -1;
+
+         while (table_index < needle_size)
+         {
+            if (needle[table_index] == needle[candidate_index]) {
+               this->partial_table[table_index] = this->partial_table[candidate_index];
+            }
+            else {
+               this->partial_table[table_index] = candidate_index;
+
+               while (candidate_index >= 0 && needle[table_index] != needle[candidate_index])
+                  candidate_index = this->partial_table[candidate_index];
+            }
+
+            ++table_index; ++candidate_index;
+         }
+
+         this->partial_table[table_index] = candidate_index;
+      }
+
+      void feed(const std::uint8_t *haystack, std::size_t size, std::vector<std::size_t> &results) {
+         if (this->needle_size == 0) { return; }
+
+         for (std::size_t i=0; i<size; ++i, ++this->position)
+         {
+            for (;;)
+            {
+               if (haystack[i] == this->needle[this->needle_index])
+               {
+                  ++this->needle_index;
+
+                  if (this->needle_index == static_cast<std::int64_t>(this->needle_size))
+                  {
+                     results.push_back(this->position+1-this->needle_size);
+                     this->needle_index = this->partial_table[this->needle_index];
+                  }
+
+                  break;
+               }
+
+               this->needle_index = this->partial_table[this->needle_index];
+
+               if (this->needle_index < 0)
+               {
+                  ++this->needle_index;
+                  break;
+               }
+            }
+         }
+      }
+   };
+}}
+
+#endif
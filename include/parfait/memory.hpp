@@ -1,77 +1,245 @@
 #ifndef __PARFAIT_MEMORY_H
 #define __PARFAIT_MEMORY_H
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <type_traits>
 #include <utility>
 
 #include <intervaltree.hpp>
 
+#include <parfait/atomic.hpp>
 #include <parfait/exception.hpp>
+#include <parfait/flat.hpp>
+#include <parfait/kernel.hpp>
+#include <parfait/pool.hpp>
+#include <parfait/span.hpp>
 
 namespace parfait
 {
    template <typename ValueType, bool Inclusive=false>
    using Interval = intervaltree::Interval<ValueType, Inclusive>;
 
+   template <typename T>
+   class Pin;
+
    class Memory
    {
    public:
       using IntervalType = Interval<std::uintptr_t>;
+
+      // fills, searches, comparisons and hex dumps at least this big are split across the
+      // shared thread pool
+      static constexpr std::size_t ParallelThreshold = static_cast<std::size_t>(1) << 20;
       
    protected:
       class Manager
       {
       public:
-         template <typename IntervalType>
-         using IntervalTree = intervaltree::IntervalTree<IntervalType>;
-         
-         template <typename IntervalType, typename Value>
-         using IntervalMap = intervaltree::IntervalMap<IntervalType, Value>;
-
          struct MemoryInfo
          {
             std::size_t refcount;
-            std::set<Memory *> objects;
+            FlatSet<Memory *> objects;
             std::optional<IntervalType> parent;
-            IntervalTree<IntervalType> children;
-
-            MemoryInfo() : refcount(0), parent(std::nullopt) {}
+            FlatSet<IntervalType> children;
+            Generation *generation;
+            // the furthest any span or pin bound to the generation reaches
+            std::uintptr_t reach;
+            std::size_t pins;
+            // copy-on-write objects still aliasing someone else's bytes through this region
+            FlatSet<Memory *> borrowers;
+
+            MemoryInfo() : refcount(0), parent(std::nullopt), generation(nullptr), reach(0), pins(0) {}
             MemoryInfo(const MemoryInfo &other) : refcount(other.refcount),
                                                   objects(other.objects),
                                                   parent(other.parent),
-                                                  children(other.children) {}
+                                                  children(other.children),
+                                                  generation(other.generation),
+                                                  reach(other.reach),
+                                                  pins(other.pins),
+                                                  borrowers(other.borrowers) {}
+
+            MemoryInfo &operator=(const MemoryInfo &) = default;
+
+            // back to a fresh record, keeping any storage the lists have grown
+            void reset() {
+               this->refcount = 0;
+               this->objects.clear();
+               this->parent = std::nullopt;
+               this->children.clear();
+               this->generation = nullptr;
+               this->reach = 0;
+               this->pins = 0;
+               this->borrowers.clear();
+            }
+         };
+
+         // generation slots are recycled but never freed, so a span can always safely
+         // read the slot it was handed to find out if its region is still current
+         class GenerationTable
+         {
+            std::deque<Generation> slots;
+            std::vector<Generation *> free_slots;
+
+         public:
+            Generation *acquire() {
+               if (this->free_slots.size() > 0)
+               {
+                  auto slot = this->free_slots.back();
+                  this->free_slots.pop_back();
+                  return slot;
+               }
+
+               this->slots.emplace_back(0);
+               return &this->slots.back();
+            }
+
+            void retire(Generation *slot) {
+               slot->fetch_add(1, std::memory_order_release);
+               this->free_slots.push_back(slot);
+            }
+
+            void retire_all() {
+               this->free_slots.clear();
+
+               for (auto &slot : this->slots)
+                  this->retire(&slot);
+            }
          };
 
-         class MemoryMap : public IntervalMap<IntervalType, MemoryInfo>
+         // the regions a domain knows about. records live in a recycling pool and are found
+         // through the flat index, so declaring and destroying regions doesn't allocate once
+         // the pool and index have grown to the domain's working size.
+         class MemoryMap
          {
+            GenerationTable generations;
+            FlatIntervalIndex<IntervalType> index;
+            SlotPool<MemoryInfo> records;
+            // the regions that have borrowers, so an owner only looks at the ones it overlaps
+            FlatIntervalIndex<IntervalType> borrowed;
+
+            void retire(IntervalType key) {
+               auto &info = (*this)[key];
+
+               if (info.generation == nullptr) { return; }
+
+               this->generations.retire(info.generation);
+               info.generation = nullptr;
+               info.reach = 0;
+            }
+
          public:
-            MemoryMap() : IntervalMap() {}
-            MemoryMap(const MemoryMap &other) : IntervalMap(other) {}
+            using SetType = std::set<IntervalType>;
+
+            MemoryMap() {}
+            MemoryMap(const MemoryMap &other) : index(other.index), records(other.records), borrowed(other.borrowed) {}
+
+            // a missing key gets a fresh record
+            MemoryInfo &operator[](IntervalType key) {
+               auto slot = this->index.find(key);
+               if (slot != nullptr) { return this->records[*slot]; }
+
+               auto fresh = this->records.acquire();
+               this->index.insert(key, fresh);
+
+               return this->records[fresh];
+            }
+
+            void remove(IntervalType key) {
+               auto slot = this->index.find(key);
+               if (slot == nullptr) { return; }
+
+               if (this->records[*slot].borrowers.size() > 0) { this->borrowed.erase(key); }
 
-            void ref(IntervalType key) {
+               this->records.release(*slot);
+               this->index.erase(key);
+            }
+
+            inline bool has_interval(IntervalType key) const { return this->index.has(key); }
+            inline bool contains(IntervalType key) const { return this->index.has(key); }
+
+            // whether any region contains the key, without building the set of them
+            inline bool covers(IntervalType key) const { return this->index.covers(key.low, key.high); }
+
+            SetType containing_interval(IntervalType key) const {
+               SetType result;
+               this->index.containing(key.low, key.high, [&result](const IntervalType &region, std::size_t) { result.insert(region); });
+
+               return result;
+            }
+
+            inline std::size_t record_allocations() const { return this->records.allocations(); }
+            inline std::size_t record_reuses() const { return this->records.reuses(); }
+            inline std::size_t index_allocations() const { return this->index.allocations(); }
+
+            // forget every region at once. anything still holding a generation sees it go stale.
+            void clear() {
+               this->generations.retire_all();
+               this->index.clear();
+               this->records.clear();
+               this->borrowed.clear();
+            }
+
+            bool borrow(Memory *object) {
+               auto key = object->interval();
+               auto &info = (*this)[key];
+
+               if (!info.borrowers.insert(object)) { return false; }
+               if (info.borrowers.size() == 1) { this->borrowed.insert(key); }
+
+               return true;
+            }
+
+            bool release(Memory *object) {
+               auto key = object->interval();
+               if (!this->has_interval(key)) { return false; }
+
+               auto &info = (*this)[key];
+
+               if (!info.borrowers.erase(object)) { return false; }
+               if (info.borrowers.size() == 0) { this->borrowed.erase(key); }
+
+               return true;
+            }
+
+            // every borrower aliasing any part of the key, other than the given object
+            void borrowers(IntervalType key, const Memory *except, std::vector<Memory *> &result) {
+               this->borrowed.overlapping(key.low, key.high, [this, except, &result](const IntervalType &region, std::size_t) {
+                  for (auto borrower : (*this)[region].borrowers)
+                     if (borrower != except) { result.push_back(borrower); }
+               });
+            }
+
+            void ref(IntervalType key, std::size_t count=1) {
                // std::cout << "Ref: " << std::hex << key.low << "," << key.high << std::endl;
-               ++(*this)[key].refcount;
+               (*this)[key].refcount += count;
 
                for (auto parent=(*this)[key].parent; parent.has_value(); parent=(*this)[*parent].parent)
-                  ++(*this)[*parent].refcount;
+                  (*this)[*parent].refcount += count;
             }
 
-            void deref(IntervalType key) {
+            void deref(IntervalType key, std::size_t count=1) {
                // std::cout << "Deref: " << std::hex << key.low << "," << key.high << std::endl;
-               auto invalidated = std::vector<IntervalType>();
+               // ancestor chains are short, so this stays in inline storage
+               FlatSet<IntervalType, 8> invalidated;
 
                for (std::optional<IntervalType> node=key; node.has_value(); node=(*this)[*node].parent)
                {
-                  if (--(*this)[*node].refcount == 0)
-                     invalidated.push_back(*node);
+                  (*this)[*node].refcount -= count;
+
+                  if ((*this)[*node].refcount == 0)
+                     invalidated.insert(*node);
                }
 
                for (auto region : invalidated)
@@ -104,6 +272,30 @@ namespace parfait
                this->ref(parent_key);
             }
 
+            // declare every child and parent them all at once. the parent's child list is
+            // merged and its chain walked once for the lot rather than once per child.
+            void declare_children(IntervalType parent_key, Memory *const *children, std::size_t count) {
+               std::vector<IntervalType> parented;
+               parented.reserve(count);
+
+               for (std::size_t i=0; i<count; ++i)
+               {
+                  auto child_key = children[i]->interval();
+                  (*this)[child_key].objects.insert(children[i]);
+                  this->ref(child_key);
+
+                  if (child_key == parent_key) { continue; }
+
+                  (*this)[child_key].parent = parent_key;
+                  parented.push_back(child_key);
+               }
+
+               if (parented.size() == 0) { return; }
+
+               (*this)[parent_key].children.insert(parented.begin(), parented.end());
+               this->ref(parent_key, parented.size());
+            }
+
             void destroy(const Memory *object) {
                auto key = object->interval();
                // std::cout << "Destroy: " << std::hex << key.low << "," << key.high << std::endl;
@@ -112,6 +304,64 @@ namespace parfait
                this->deref(key);
             }
 
+            // destroy many objects, dropping the references each one held on its parent in
+            // one walk per parent. regions nothing refers to anymore leave their parent's
+            // child list together. objects that aren't declared are skipped.
+            void destroy(const Memory *const *objects, std::size_t count) {
+               std::vector<std::pair<IntervalType,std::size_t>> parents;
+               std::vector<std::pair<IntervalType,IntervalType>> orphaned;
+               std::vector<IntervalType> invalidated;
+
+               for (std::size_t i=0; i<count; ++i)
+               {
+                  auto key = objects[i]->interval();
+                  if (!this->contains(key)) { continue; }
+
+                  auto &info = (*this)[key];
+                  if (info.objects.erase(const_cast<Memory *>(objects[i])) == 0) { continue; }
+
+                  auto parent_key = info.parent;
+
+                  if (--info.refcount == 0)
+                  {
+                     invalidated.push_back(key);
+
+                     // the parent still has this batch's references, so it outlives the child
+                     if (parent_key.has_value())
+                     {
+                        orphaned.push_back(std::make_pair(*parent_key, key));
+                        info.parent = std::nullopt;
+                     }
+                  }
+
+                  if (!parent_key.has_value()) { continue; }
+
+                  auto parent = std::find_if(parents.begin(), parents.end(),
+                                             [&parent_key](const std::pair<IntervalType,std::size_t> &entry) { return entry.first == *parent_key; });
+
+                  if (parent == parents.end()) { parents.push_back(std::make_pair(*parent_key, 1)); }
+                  else { ++parent->second; }
+               }
+
+               std::sort(orphaned.begin(), orphaned.end());
+
+               for (std::size_t begin=0, end=0; begin<orphaned.size(); begin=end)
+               {
+                  std::vector<IntervalType> leaving;
+
+                  for (end=begin; end<orphaned.size() && orphaned[end].first == orphaned[begin].first; ++end)
+                     leaving.push_back(orphaned[end].second);
+
+                  (*this)[orphaned[begin].first].children.erase(leaving.begin(), leaving.end());
+               }
+
+               for (auto region : invalidated)
+                  this->invalidate(region);
+
+               for (auto &parent : parents)
+                  if (this->has_interval(parent.first)) { this->deref(parent.first, parent.second); }
+            }
+
             void invalidate(const Memory *object) {
                this->invalidate(object->interval());
             }
@@ -122,14 +372,72 @@ namespace parfait
                // std::cout << "Invalidate: " << std::hex << invalid.low << "," << invalid.high << std::endl;
                
                if ((*this)[invalid].parent.has_value())
-                  (*this)[*(*this)[invalid].parent].children.remove(invalid);
+                  (*this)[*(*this)[invalid].parent].children.erase(invalid);
                
-               for (auto child : (*this)[invalid].children)
+               // invalidating a child removes it from our children, so walk a copy
+               auto children = (*this)[invalid].children;
+
+               for (auto child : children)
                   this->invalidate(child);
 
+               this->retire(invalid);
                this->remove(invalid);
             }
 
+            // a pin holds a reference like a child would, so the region outlives the object
+            // it was taken from
+            void pin(IntervalType key) {
+               ++(*this)[key].pins;
+               this->ref(key);
+            }
+
+            void unpin(IntervalType key) {
+               if (!this->has_interval(key)) { return; }
+
+               --(*this)[key].pins;
+               this->deref(key);
+            }
+
+            // a region is pinned if it or anything viewing into it is
+            bool is_pinned(IntervalType key) {
+               if (!this->has_interval(key)) { return false; }
+
+               auto &info = (*this)[key];
+
+               if (info.pins > 0) { return true; }
+
+               for (auto child : info.children)
+                  if (this->is_pinned(child)) { return true; }
+
+               return false;
+            }
+
+            const Generation *generation(IntervalType key) {
+               // bind to the outermost region containing the key, so the generation survives
+               // temporary views over the same memory coming and going
+               std::optional<IntervalType> root = std::nullopt;
+               std::size_t root_slot = 0;
+
+               this->index.containing(key.low, key.high, [&root, &root_slot](const IntervalType &region, std::size_t slot) {
+                  if (!root.has_value() || region.size() > root->size())
+                  {
+                     root = region;
+                     root_slot = slot;
+                  }
+               });
+
+               if (!root.has_value()) { return nullptr; }
+
+               auto &info = this->records[root_slot];
+
+               if (info.generation == nullptr)
+                  info.generation = this->generations.acquire();
+
+               if (key.high > info.reach) { info.reach = key.high; }
+
+               return info.generation;
+            }
+
             void move(Memory *object, void *pointer, std::size_t size)
             {
                auto from_interval = object->interval();
@@ -138,6 +446,9 @@ namespace parfait
                auto ptr_delta = static_cast<std::intptr_t>(to_interval.low) - static_cast<std::intptr_t>(from_interval.low);
                std::optional<IntervalType> deleted_interval = std::nullopt;
 
+               // re-keying regions onto themselves would drop them, and nothing moves anyway
+               if (to_interval.low == from_interval.low) { return this->resize(object, size); }
+
                if (to_interval.size() < from_interval.size())
                {
                   deleted_interval = IntervalType(from_interval.low+to_interval.size(), from_interval.high);
@@ -166,6 +477,8 @@ namespace parfait
                      moved_region = IntervalType(region.low+ptr_delta, region.high+ptr_delta);
                   }
 
+                  // anything viewing the old region is stale now, regardless of where it landed
+                  this->retire(region);
                   auto old_info = (*this)[region];
 
                   if (this->contains(moved_region))
@@ -197,7 +510,7 @@ namespace parfait
                      object->unlock();
                   }
 
-                  IntervalTree<IntervalType> new_children;
+                  FlatSet<IntervalType> new_children;
 
                   for (auto child_region : (*this)[moved_region].children)
                   {
@@ -225,29 +538,187 @@ namespace parfait
                   this->remove(region);
                }
             }
+
+            // grow or shrink an object's region without moving its base. unlike move(), views
+            // that still fit are left alone and keep their generation, so they stay valid.
+            void resize(Memory *object, std::size_t size)
+            {
+               auto from = object->interval();
+               auto to = IntervalType(from.low, from.low+size);
+
+               if (from == to || !this->has_interval(from)) { return; }
+
+               if (to.high < from.high)
+               {
+                  // views reaching past the new end would point at memory we no longer own
+                  std::vector<IntervalType> stale;
+
+                  for (auto child : (*this)[from].children)
+                     if (child.high > to.high) { stale.push_back(child); }
+
+                  for (auto child : stale)
+                     this->invalidate(child);
+
+                  // spans and pins share the region's generation, so it only goes stale if one
+                  // of them reaches past the new end. the ones that fit stay valid otherwise.
+                  if ((*this)[from].reach > to.high) { this->retire(from); }
+               }
+
+               auto info = (*this)[from];
+               this->remove(from);
+
+               if (info.parent.has_value())
+               {
+                  (*this)[*info.parent].children.erase(from);
+                  (*this)[*info.parent].children.insert(to);
+               }
+
+               if (this->has_interval(to))
+               {
+                  // a view covering exactly the new size folds into the object's region. its
+                  // references were already counted in ours if it was one of our descendants.
+                  auto &existing = (*this)[to];
+                  auto descendant = existing.parent.has_value() && *existing.parent == from;
+
+                  for (auto region_object : info.objects)
+                     existing.objects.insert(region_object);
+
+                  for (auto child : info.children)
+                     if (child != to) { existing.children.insert(child); }
+
+                  existing.refcount = (descendant) ? info.refcount : existing.refcount + info.refcount;
+
+                  if (descendant || !existing.parent.has_value()) { existing.parent = info.parent; }
+
+                  // spans bind to the outermost region, so ours are the ones worth keeping
+                  if (info.generation != nullptr)
+                  {
+                     if (existing.generation != nullptr) { this->generations.retire(existing.generation); }
+
+                     existing.generation = info.generation;
+                     existing.reach = info.reach;
+                  }
+               }
+               else { (*this)[to] = info; }
+
+               for (auto child : (*this)[to].children)
+                  (*this)[child].parent = to;
+
+               for (auto region_object : (*this)[to].objects)
+               {
+                  region_object->lock();
+                  region_object->_size = to.size();
+                  region_object->unlock();
+               }
+            }
+         };
+
+         // what a domain has been asked to do since it was created. borrowers and pins are
+         // how many there are right now. the allocation counts say how often bookkeeping had
+         // to grow rather than reuse a record or index block it already had, and stop moving
+         // once the domain reaches its working size.
+         struct Statistics
+         {
+            std::size_t declarations;
+            std::size_t destructions;
+            std::size_t invalidations;
+            std::size_t moves;
+            std::size_t resizes;
+            std::size_t lookups;
+            std::size_t teardowns;
+            std::size_t borrowers;
+            std::size_t pins;
+            std::size_t record_allocations;
+            std::size_t record_reuses;
+            std::size_t index_allocations;
+
+            Statistics() : declarations(0), destructions(0), invalidations(0), moves(0), resizes(0),
+                           lookups(0), teardowns(0), borrowers(0), pins(0),
+                           record_allocations(0), record_reuses(0), index_allocations(0) {}
+         };
+
+         // binds the objects this thread creates to a domain until it goes out of scope.
+         // views and copies of an object always land in the object's own domain.
+         class Scope
+         {
+            Manager *previous;
+
+         public:
+            Scope(Manager &domain) : previous(Manager::Current) { Manager::Current = &domain; }
+            Scope(const Scope &) = delete;
+            ~Scope() { Manager::Current = this->previous; }
+
+            Scope &operator=(const Scope &) = delete;
          };
 
          static std::unique_ptr<Manager> Instance;
+         static std::once_flag InstanceFlag;
+         static thread_local Manager *Current;
          MemoryMap memory_map;
-         std::map<const Memory *,std::mutex> object_mutexes;
          std::mutex map_mutex;
-
-         Manager() {}
+         // held across a whole detach pass, so a borrower can't leave (or be destroyed) while
+         // it's copying out. recursive because detaching releases the borrower.
+         std::recursive_mutex borrower_mutex;
+         std::atomic<std::size_t> borrower_count;
+         std::atomic<std::size_t> detach_passes;
+         std::atomic<std::size_t> pin_count;
+         // guarded by map_mutex
+         Statistics counters;
+
+         // a domain of its own, with a registry, locks and statistics nobody else touches.
+         // it must outlive every object bound to it.
+         Manager() : borrower_count(0), detach_passes(0), pin_count(0) {}
+         Manager(const Manager &) = delete;
+
+         Manager &operator=(const Manager &) = delete;
 
       public:
+         // the default domain, for everything not created inside a scope
          static Manager &get_instance() {
-            if (Manager::Instance == nullptr)
-               Manager::Instance = std::unique_ptr<Manager>(new Manager());
-
+            std::call_once(Manager::InstanceFlag, []() { Manager::Instance = std::unique_ptr<Manager>(new Manager()); });
             return *Manager::Instance;
          }
 
-         void lock(const Memory *object) {
-            this->object_mutexes[object].lock();
+         // the domain new objects on this thread are bound to
+         static Manager &current() {
+            if (Manager::Current != nullptr) { return *Manager::Current; }
+            return Manager::get_instance();
          }
 
-         void unlock(const Memory *object) {
-            this->object_mutexes[object].unlock();
+         Statistics statistics() {
+            this->map_mutex.lock();
+            auto result = this->counters;
+            result.record_allocations = this->memory_map.record_allocations();
+            result.record_reuses = this->memory_map.record_reuses();
+            result.index_allocations = this->memory_map.index_allocations();
+            this->map_mutex.unlock();
+
+            result.borrowers = this->borrower_count.load(std::memory_order_acquire);
+            result.pins = this->pin_count.load(std::memory_order_acquire);
+
+            return result;
+         }
+
+         // drop every region in the domain in one go rather than object by object. objects
+         // still bound to it are left undeclared: views and spans into them read as invalid,
+         // and the objects themselves are only good for freeing what they own. refused while
+         // anything is pinned.
+         void teardown() {
+            this->map_mutex.lock();
+
+            auto pins = this->pin_count.load(std::memory_order_acquire);
+
+            if (pins > 0)
+            {
+               this->map_mutex.unlock();
+               throw exception::DomainInUse(pins);
+            }
+
+            // the borrower records go with the map
+            this->memory_map.clear();
+            this->borrower_count = 0;
+            ++this->counters.teardowns;
+            this->map_mutex.unlock();
          }
 
          bool has_interval(const void *ptr, std::size_t size) {
@@ -255,6 +726,7 @@ namespace parfait
             auto key = Memory::IntervalType(base, base+size);
 
             this->map_mutex.lock();
+            ++this->counters.lookups;
             auto result = this->memory_map.has_interval(key);
             this->map_mutex.unlock();
 
@@ -265,7 +737,8 @@ namespace parfait
             auto base = reinterpret_cast<std::uintptr_t>(ptr);
 
             this->map_mutex.lock();
-            auto result = this->memory_map.containing_point(base).size() > 0;
+            ++this->counters.lookups;
+            auto result = this->memory_map.covers(Memory::IntervalType(base, base+1));
             this->map_mutex.unlock();
 
             return result;
@@ -276,7 +749,8 @@ namespace parfait
             auto key = Memory::IntervalType(base, base+size);
 
             this->map_mutex.lock();
-            auto result = this->memory_map.containing_interval(key).size() > 0;
+            ++this->counters.lookups;
+            auto result = this->memory_map.covers(key);
             this->map_mutex.unlock();
 
             return result;
@@ -287,6 +761,7 @@ namespace parfait
             auto key = Memory::IntervalType(base, base+size);
 
             this->map_mutex.lock();
+            ++this->counters.lookups;
             auto result = this->memory_map.containing_interval(key);
             this->map_mutex.unlock();
 
@@ -295,52 +770,179 @@ namespace parfait
 
          void declare(Memory *object) {
             this->map_mutex.lock();
+            ++this->counters.declarations;
             this->memory_map.declare(object);
             this->map_mutex.unlock();
          }
 
          void declare_child(const Memory *parent, Memory *child) {
             this->map_mutex.lock();
+            ++this->counters.declarations;
             this->memory_map.declare_child(parent, child);
             this->map_mutex.unlock();
          }
 
          void declare_child(IntervalType parent_key, Memory *child) {
             this->map_mutex.lock();
+            ++this->counters.declarations;
             this->memory_map.declare_child(parent_key, child);
             this->map_mutex.unlock();
          }
 
+         // declare a batch of views into one parent under a single lock
+         void declare_children(const Memory *parent, Memory *const *children, std::size_t count) {
+            auto parent_key = parent->interval();
+
+            this->map_mutex.lock();
+            this->counters.declarations += count;
+            this->memory_map.declare_children(parent_key, children, count);
+            this->map_mutex.unlock();
+         }
+
          void destroy(const Memory *object) {
             this->map_mutex.lock();
+            ++this->counters.destructions;
             this->memory_map.destroy(object);
             this->map_mutex.unlock();
+         }
 
-            // if the mutex is locked, we're in the middle of modifying the object,
-            // so don't destroy the mutex
-            if (this->object_mutexes.find(object) != this->object_mutexes.end() && this->object_mutexes[object].try_lock())
-            {
-               this->object_mutexes[object].unlock();
-               this->object_mutexes.erase(object);
-            }
+         void destroy(const Memory *const *objects, std::size_t count) {
+            this->map_mutex.lock();
+            this->counters.destructions += count;
+            this->memory_map.destroy(objects, count);
+            this->map_mutex.unlock();
          }
 
          void invalidate(const Memory *object) {
+            this->check_unpinned(object);
+            this->detach_borrowers(object);
+
             this->map_mutex.lock();
+            ++this->counters.invalidations;
             this->memory_map.invalidate(object);
             this->map_mutex.unlock();
+         }
+
+         void move(Memory *object, void *ptr, std::size_t size) {
+            this->check_unpinned(object);
+            this->detach_borrowers(object);
+
+            this->map_mutex.lock();
+            ++this->counters.moves;
+            this->memory_map.move(object, ptr, size);
+            this->map_mutex.unlock();
+         }
+
+         void resize(Memory *object, std::size_t size) {
+            this->check_unpinned(object);
+
+            // borrowers sharing the object's region would be resized along with it
+            this->detach_borrowers(object);
+
+            this->map_mutex.lock();
+            ++this->counters.resizes;
+            this->memory_map.resize(object, size);
+            this->map_mutex.unlock();
+         }
 
-            if (this->object_mutexes.find(object) != this->object_mutexes.end() && this->object_mutexes[object].try_lock())
+         const Generation *pin(IntervalType key) {
+            this->map_mutex.lock();
+
+            if (!this->memory_map.has_interval(key))
             {
-               this->object_mutexes[object].unlock();
-               this->object_mutexes.erase(object);
+               this->map_mutex.unlock();
+               throw exception::InvalidPointer(reinterpret_cast<const void *>(key.low), key.size());
             }
+
+            this->memory_map.pin(key);
+            ++this->pin_count;
+            auto result = this->memory_map.generation(key);
+            this->map_mutex.unlock();
+
+            return result;
          }
 
-         void move(Memory *object, void *ptr, std::size_t size) {
+         // a pin whose region was torn down by its object's destructor has nothing left to
+         // unpin, and the key may belong to a newer region by now
+         void unpin(IntervalType key, const Generation *slot, std::uint64_t generation) {
             this->map_mutex.lock();
-            this->memory_map.move(object, ptr, size);
+            if (slot == nullptr || slot->load(std::memory_order_acquire) == generation) { this->memory_map.unpin(key); }
+            --this->pin_count;
+            this->map_mutex.unlock();
+         }
+
+         bool is_pinned(const Memory *object) {
+            if (this->pin_count.load(std::memory_order_acquire) == 0) { return false; }
+
+            auto key = object->interval();
+
+            this->map_mutex.lock();
+            auto result = this->memory_map.is_pinned(key);
+            this->map_mutex.unlock();
+
+            return result;
+         }
+
+         // an object being destroyed goes regardless. its region is still retired, so its pins
+         // see their spans go stale, but raw pointers taken from them dangle.
+         void check_unpinned(const Memory *object) {
+            if (object->tearing_down) { return; }
+            if (this->is_pinned(object)) { throw exception::Pinned(object->pointer.c, object->_size); }
+         }
+
+         // copy-on-write objects register as borrowers while they still alias someone
+         // else's bytes, so the owner can make them take their copy before it changes them
+         void borrow(Memory *object) {
+            this->borrower_mutex.lock();
+            this->map_mutex.lock();
+            if (this->memory_map.borrow(object)) { ++this->borrower_count; }
             this->map_mutex.unlock();
+            this->borrower_mutex.unlock();
+         }
+
+         // waits out any detach pass that's copying the object, so it's safe to tear down after
+         void release(Memory *object) {
+            // a borrower the running pass already released doesn't count, but is still being copied
+            if (this->borrower_count.load() == 0 && this->detach_passes.load() == 0) { return; }
+
+            this->borrower_mutex.lock();
+            this->map_mutex.lock();
+            if (this->memory_map.release(object)) { --this->borrower_count; }
+            this->map_mutex.unlock();
+            this->borrower_mutex.unlock();
+         }
+
+         void detach_borrowers(const Memory *owner) {
+            if (this->borrower_count.load(std::memory_order_acquire) == 0) { return; }
+
+            std::vector<Memory *> detaching;
+
+            ++this->detach_passes;
+            this->borrower_mutex.lock();
+
+            this->map_mutex.lock();
+            this->memory_map.borrowers(owner->interval(), owner, detaching);
+            this->map_mutex.unlock();
+
+            // no map lock is held here, so the borrowers are free to allocate. a borrower
+            // has to release itself before it goes away, which blocks until we're done.
+            for (auto borrower : detaching)
+               borrower->detach();
+
+            this->borrower_mutex.unlock();
+            --this->detach_passes;
+         }
+
+         const Generation *generation(const void *ptr, std::size_t size) {
+            auto base = reinterpret_cast<std::uintptr_t>(ptr);
+            auto key = Memory::IntervalType(base, base+size);
+
+            this->map_mutex.lock();
+            ++this->counters.lookups;
+            auto result = this->memory_map.generation(key);
+            this->map_mutex.unlock();
+
+            return result;
          }
 
          std::optional<IntervalType> parent(const Memory *object) {
@@ -359,6 +961,7 @@ namespace parfait
             auto key = object->interval();
 
             this->map_mutex.lock();
+            ++this->counters.lookups;
             auto has_interval = this->memory_map.has_interval(key);
             
             if (!has_interval) {
@@ -373,26 +976,167 @@ namespace parfait
          }
       };
       
+      // a reader/writer lock kept in the object itself. it guards the object's pointer and
+      // size and serializes writes through it, while reads only need a shared lock. copies
+      // start with a fresh, unlocked mutex.
+      class ObjectLock
+      {
+         std::shared_mutex mutex;
+
+      public:
+         ObjectLock() {}
+         ObjectLock(const ObjectLock &) {}
+         ObjectLock &operator=(const ObjectLock &) { return *this; }
+
+         void lock() { this->mutex.lock(); }
+         void unlock() { this->mutex.unlock(); }
+         void lock_shared() { this->mutex.lock_shared(); }
+         void unlock_shared() { this->mutex.unlock_shared(); }
+      };
+
       union {
          const void *c;
          void *m;
       } pointer;
       std::size_t _size;
+      mutable ObjectLock object_lock;
+      Manager *_domain;
+      // set by destructors, whose teardown can't be refused for being pinned
+      bool tearing_down;
+
+      // an empty object bound to a particular domain rather than the current one
+      Memory(Manager &domain) : _size(0), _domain(&domain), tearing_down(false) { this->pointer.c = nullptr; }
+
+      Manager &manager() const { return *this->_domain; }
+      void lock() const { this->object_lock.lock(); }
+      void unlock() const { this->object_lock.unlock(); }
+      void lock_shared() const { this->object_lock.lock_shared(); }
+      void unlock_shared() const { this->object_lock.unlock_shared(); }
+
+      // the chunk size for a bulk operation, or the whole range if it's too small to split.
+      // chunks start on multiples of the given size.
+      static std::size_t parallel_grain(std::size_t size, std::size_t multiple=1) {
+         if (size < ParallelThreshold) { return size; }
+         return ThreadPool::get_instance().grain_for(size, multiple);
+      }
+
+      // the caller holds the object's lock for the whole loop, the pool's threads only
+      // ever touch the bytes
+      static void parallel_for(std::size_t size, std::size_t grain, const std::function<void(std::size_t,std::size_t)> &body) {
+         if (grain >= size) { return body(0, size); }
+         ThreadPool::get_instance().parallel_for(size, body, grain);
+      }
 
-      Manager &manager() const { return Manager::get_instance(); }
-      void lock() const { this->manager().lock(this); }
-      void unlock() const { this->manager().unlock(this); }
+      // called before the bytes are changed through the object's own interface. plain memory
+      // makes any copy-on-write borrowers of its region take their copies first.
+      virtual void prepare_write() { this->manager().detach_borrowers(this); }
+
+      // mutable access on behalf of a write. plain ptr() hands out the bytes as they are.
+      void *write_ptr(std::size_t offset=0) {
+         this->prepare_write();
+         return this->ptr(offset);
+      }
+
+      // called by the manager when this object is a copy-on-write borrower and the
+      // region it borrows from is about to change
+      virtual void detach() {}
+
+      // lock two objects in address order so that concurrent a-vs-b and b-vs-a
+      // operations can't deadlock each other. this object is locked exclusively, the
+      // other one only shared if it's just being read.
+      void lock_with(const Memory &other, bool shared_other=false) const {
+         if (&other == this) { return this->lock(); }
+
+         if (this < &other) { this->lock(); }
+
+         if (shared_other) { other.lock_shared(); }
+         else { other.lock(); }
+
+         if (&other < this) { this->lock(); }
+      }
+      void unlock_with(const Memory &other, bool shared_other=false) const {
+         if (&other == this) { return this->unlock(); }
+
+         this->unlock();
+
+         if (shared_other) { other.unlock_shared(); }
+         else { other.unlock(); }
+      }
+
+      void lock_shared_with(const Memory &other) const {
+         if (&other == this) { return this->lock_shared(); }
+
+         auto first = (this < &other) ? this : &other;
+         auto second = (this < &other) ? &other : this;
+
+         first->lock_shared();
+         second->lock_shared();
+      }
+      void unlock_shared_with(const Memory &other) const {
+         if (&other == this) { return this->unlock_shared(); }
+
+         this->unlock_shared();
+         other.unlock_shared();
+      }
+
+      // the bounds, validity and alignment checks for count atomic slots of T at offset.
+      // the region is only checked once, however many slots a batch touches.
+      template <typename T>
+      T *atomic_ptr(std::size_t offset, std::size_t count) {
+         static_assert(AtomicRef<T>::is_always_lock_free, "Atomic operations need a lock-free type.");
+
+         if (offset+count*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+count*sizeof(T), this->_size); }
+
+         auto ptr = this->write_ptr(offset);
+         if (ptr == nullptr) { throw exception::NullPointer(); }
+         if (reinterpret_cast<std::uintptr_t>(ptr) % AtomicRef<T>::required_alignment != 0) { throw exception::BadAlignment(offset, AtomicRef<T>::required_alignment); }
+
+         return static_cast<T *>(ptr);
+      }
+
+      template <typename T>
+      T *atomic_ptr(std::size_t offset, std::size_t count) const {
+         static_assert(AtomicRef<T>::is_always_lock_free, "Atomic operations need a lock-free type.");
+
+         if (offset+count*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+count*sizeof(T), this->_size); }
+
+         auto ptr = this->ptr(offset);
+         if (ptr == nullptr) { throw exception::NullPointer(); }
+         if (reinterpret_cast<std::uintptr_t>(ptr) % AtomicRef<T>::required_alignment != 0) { throw exception::BadAlignment(offset, AtomicRef<T>::required_alignment); }
+
+         // atomic_ref can't view const objects, loads never write through it anyway
+         return const_cast<T *>(static_cast<const T *>(ptr));
+      }
+
+      template <typename T, typename Op>
+      void atomic_batch(std::size_t offset, const T *values, std::size_t count, Op op) {
+         if (count == 0) { return; }
+
+         auto base = this->atomic_ptr<T>(offset, count);
+
+         for (std::size_t i=0; i<count; ++i)
+            op(AtomicRef<T>(base[i]), values[i]);
+      }
 
    public:
       friend class Manager;
       friend class Manager::MemoryMap;
+
+      template <typename T>
+      friend class Pin;
+
+      // a registry of regions, with its own locks and statistics. objects are bound to the
+      // domain current on the thread that creates them, see Domain::Scope.
+      using Domain = Manager;
       
-      Memory() : _size(0) { this->pointer.c = nullptr; }
-      Memory(void *pointer, std::size_t size) : _size(size) { this->pointer.m = pointer; this->manager().declare(this); }
-      Memory(const void *pointer, std::size_t size) : _size(size) { this->pointer.c = pointer; this->manager().declare(this); }
-      Memory(const Memory &other) : _size(other._size) { this->pointer.m = other.pointer.m; this->manager().declare(this); }
+      Memory() : _size(0), _domain(&Manager::current()), tearing_down(false) { this->pointer.c = nullptr; }
+      Memory(void *pointer, std::size_t size) : _size(size), _domain(&Manager::current()), tearing_down(false) { this->pointer.m = pointer; this->manager().declare(this); }
+      Memory(const void *pointer, std::size_t size) : _size(size), _domain(&Manager::current()), tearing_down(false) { this->pointer.c = pointer; this->manager().declare(this); }
+      Memory(const Memory &other) : _size(other._size), _domain(other._domain), tearing_down(false) { this->pointer.m = other.pointer.m; this->manager().declare(this); }
       virtual ~Memory() { if (this->manager().has_object(this)) { this->manager().destroy(this); } }
 
+      inline Domain &domain() const { return *this->_domain; }
+
       IntervalType interval() const {
          auto base = reinterpret_cast<std::uintptr_t>(this->pointer.c);
          return IntervalType(base,base+this->_size);
@@ -437,52 +1181,52 @@ namespace parfait
       inline void *eob() { return reinterpret_cast<void *>(reinterpret_cast<std::uintptr_t>(this->pointer.m)+this->_size); }
       inline const void *eob() const { return reinterpret_cast<const void *>(reinterpret_cast<std::uintptr_t>(this->pointer.c)+this->_size); }
       void *ptr(std::size_t offset=0) {
-         this->lock();
+         this->lock_shared();
          
-         if (this->pointer.m == nullptr) { this->unlock(); return nullptr; }
+         if (this->pointer.m == nullptr) { this->unlock_shared(); return nullptr; }
 
          if (!this->is_valid())
          {
             auto ptr = this->pointer.c;
             auto size = this->_size;
-            this->unlock();
+            this->unlock_shared();
             throw exception::InvalidPointer(ptr, size);
          }
 
          if (offset >= this->_size)
          {
             auto size = this->_size;
-            this->unlock();
+            this->unlock_shared();
             throw exception::OutOfBounds(offset, size);
          }
          
          auto result = reinterpret_cast<void *>(reinterpret_cast<std::uintptr_t>(this->pointer.m)+offset);
-         this->unlock();
+         this->unlock_shared();
 
          return result;
       }
       const void *ptr(std::size_t offset=0) const {
-         this->lock();
+         this->lock_shared();
          
-         if (this->pointer.c == nullptr) { this->unlock(); return nullptr; }
+         if (this->pointer.c == nullptr) { this->unlock_shared(); return nullptr; }
 
          if (!this->is_valid())
          {
             auto ptr = this->pointer.c;
             auto size = this->_size;
-            this->unlock();
+            this->unlock_shared();
             throw exception::InvalidPointer(ptr, size);
          }
 
          if (offset >= this->_size)
          {
             auto size = this->_size;
-            this->unlock();
+            this->unlock_shared();
             throw exception::OutOfBounds(offset, size);
          }
          
          auto result = reinterpret_cast<const void *>(reinterpret_cast<std::uintptr_t>(this->pointer.c)+offset);
-         this->unlock();
+         this->unlock_shared();
 
          return result;
       }
@@ -516,6 +1260,53 @@ namespace parfait
          return *this->cast_ptr<T>(offset);
       }
 
+      template <typename T=std::uint8_t>
+      Span<T> span(std::size_t offset, std::size_t size) {
+         if (offset+size*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+size*sizeof(T), this->_size); }
+         if (size == 0) { return Span<T>(); }
+
+         auto base = this->cast_ptr<T>(offset);
+         return Span<T>(base, size, this->manager().generation(base, size*sizeof(T)));
+      }
+
+      template <typename T=std::uint8_t>
+      Span<const T> span(std::size_t offset, std::size_t size) const {
+         if (offset+size*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+size*sizeof(T), this->_size); }
+         if (size == 0) { return Span<const T>(); }
+
+         auto base = this->cast_ptr<T>(offset);
+         return Span<const T>(base, size, this->manager().generation(base, size*sizeof(T)));
+      }
+
+      template <typename T=std::uint8_t>
+      Span<T> span() {
+         return this->span<T>(0, this->_size / sizeof(T));
+      }
+
+      template <typename T=std::uint8_t>
+      Span<const T> span() const {
+         return this->span<T>(0, this->_size / sizeof(T));
+      }
+
+      bool is_pinned() const { return this->manager().is_pinned(this); }
+
+      template <typename T=std::uint8_t>
+      Pin<T> pin(std::size_t offset, std::size_t size);
+
+      template <typename T=std::uint8_t>
+      Pin<const T> pin(std::size_t offset, std::size_t size) const;
+
+      template <typename T=std::uint8_t>
+      Pin<T> pin();
+
+      template <typename T=std::uint8_t>
+      Pin<const T> pin() const;
+
+      Iterator<std::uint8_t> begin() { return this->span<std::uint8_t>().begin(); }
+      Iterator<const std::uint8_t> begin() const { return this->span<std::uint8_t>().begin(); }
+      Iterator<std::uint8_t> end() { return this->span<std::uint8_t>().end(); }
+      Iterator<const std::uint8_t> end() const { return this->span<std::uint8_t>().end(); }
+
       bool aligns_with(std::size_t size) const {
          std::size_t smaller = (this->_size < size) ? this->_size : size;
          std::size_t bigger = (this->_size > size) ? this->_size : size;
@@ -544,7 +1335,9 @@ namespace parfait
       Memory subsection(std::size_t offset, std::size_t size) {
          if (offset+size > this->_size) { throw exception::InsufficientSize(offset+size, this->_size); }
 
-         auto memory = Memory(this->ptr(offset), size);
+         auto ptr = this->ptr(offset);
+         Domain::Scope scope(this->manager());
+         auto memory = Memory(ptr, size);
          this->manager().declare_child(this, &memory);
 
          return memory;
@@ -553,12 +1346,63 @@ namespace parfait
       const Memory subsection(std::size_t offset, std::size_t size) const {
          if (offset+size > this->_size) { throw exception::InsufficientSize(offset+size, this->_size); }
 
-         auto memory = Memory(this->ptr(offset), size);
+         auto ptr = this->ptr(offset);
+         Domain::Scope scope(this->manager());
+         auto memory = Memory(ptr, size);
          this->manager().declare_child(this, &memory);
 
          return memory;
       }
 
+      // a view for every (offset, size) range, all declared under one manager lock with the
+      // references on this region added in one go. destroy_subsections() drops them the
+      // same way.
+      std::vector<Memory> subsections(const std::vector<std::pair<std::size_t,std::size_t>> &ranges) {
+         for (auto &range : ranges)
+            if (range.first+range.second > this->_size) { throw exception::InsufficientSize(range.first+range.second, this->_size); }
+
+         auto base = static_cast<std::uint8_t *>(this->ptr());
+         std::vector<Memory> views;
+         std::vector<Memory *> declaring;
+
+         views.reserve(ranges.size());
+         declaring.reserve(ranges.size());
+
+         // built empty and filled in directly, so nothing is declared one view at a time
+         Domain::Scope scope(this->manager());
+
+         for (auto &range : ranges)
+         {
+            views.emplace_back();
+            views.back().pointer.m = (base == nullptr) ? nullptr : base+range.first;
+            views.back()._size = range.second;
+            declaring.push_back(&views.back());
+         }
+
+         this->manager().declare_children(this, declaring.data(), declaring.size());
+
+         return views;
+      }
+
+      // undeclare a batch of views with one manager lock per domain rather than one per view,
+      // then empty the vector
+      static void destroy_subsections(std::vector<Memory> &views) {
+         std::vector<const Memory *> destroying;
+
+         for (std::size_t begin=0, end=0; begin<views.size(); begin=end)
+         {
+            auto &domain = views[begin].manager();
+            destroying.clear();
+
+            for (end=begin; end<views.size() && &views[end].manager() == &domain; ++end)
+               destroying.push_back(&views[end]);
+
+            domain.destroy(destroying.data(), destroying.size());
+         }
+
+         views.clear();
+      }
+
       template <typename T>
       std::vector<T> read(std::size_t offset, std::size_t size) const
       {
@@ -566,7 +1410,30 @@ namespace parfait
          
          auto base = this->cast_ptr<T>(offset);
 
-         return std::vector<T>(base,base+size);
+         this->lock_shared();
+         auto result = std::vector<T>(base,base+size);
+         this->unlock_shared();
+
+         return result;
+      }
+
+      template <typename T>
+      void read_into(std::size_t offset, T* dest, std::size_t size) const
+      {
+         if (offset+size*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+size*sizeof(T), this->_size); }
+         if (size == 0) { return; }
+
+         auto base = this->cast_ptr<std::uint8_t>(offset);
+
+         this->lock_shared();
+         std::memcpy(dest, base, size*sizeof(T));
+         this->unlock_shared();
+      }
+
+      template <typename T>
+      Span<const T> read_view(std::size_t offset, std::size_t size) const
+      {
+         return this->span<T>(offset, size);
       }
 
       template <typename T>
@@ -576,13 +1443,21 @@ namespace parfait
          {
             if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
 
-            std::memcpy(this->ptr(offset), ptr, size);
+            auto dest = this->write_ptr(offset);
+
+            this->lock();
+            std::memcpy(dest, ptr, size);
+            this->unlock();
          }
          else
          {
             if (offset+size*sizeof(T) > this->_size) { throw exception::OutOfBounds(offset+size*sizeof(T), this->_size); }
 
-            std::memcpy(this->ptr(offset), ptr, size*sizeof(T));
+            auto dest = this->write_ptr(offset);
+
+            this->lock();
+            std::memcpy(dest, ptr, size*sizeof(T));
+            this->unlock();
          }
       }
 
@@ -596,6 +1471,96 @@ namespace parfait
          this->write<T>(offset, &ref);
       }
 
+      // atomic operations on the T at a byte offset, with std::atomic_ref semantics. they
+      // don't take the object's lock, so they only order against each other and must not
+      // race with the object being reallocated.
+      template <typename T>
+      T atomic_load(std::size_t offset, std::memory_order order=std::memory_order_seq_cst) const {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).load(order);
+      }
+
+      template <typename T>
+      void atomic_store(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).store(value, order);
+      }
+
+      template <typename T>
+      T atomic_exchange(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).exchange(value, order);
+      }
+
+      template <typename T>
+      bool atomic_compare_exchange(std::size_t offset, T &expected, T desired, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).compare_exchange_strong(expected, desired, order);
+      }
+
+      template <typename T>
+      T atomic_fetch_add(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).fetch_add(value, order);
+      }
+
+      template <typename T>
+      T atomic_fetch_sub(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).fetch_sub(value, order);
+      }
+
+      template <typename T>
+      T atomic_fetch_and(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).fetch_and(value, order);
+      }
+
+      template <typename T>
+      T atomic_fetch_or(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).fetch_or(value, order);
+      }
+
+      template <typename T>
+      T atomic_fetch_xor(std::size_t offset, T value, std::memory_order order=std::memory_order_seq_cst) {
+         return AtomicRef<T>(*this->atomic_ptr<T>(offset, 1)).fetch_xor(value, order);
+      }
+
+      // batch variants work slot by slot over count consecutive Ts: each slot is atomic,
+      // the batch as a whole is not
+      template <typename T>
+      void atomic_load(std::size_t offset, T *dest, std::size_t count, std::memory_order order=std::memory_order_seq_cst) const {
+         if (count == 0) { return; }
+
+         auto base = this->atomic_ptr<T>(offset, count);
+
+         for (std::size_t i=0; i<count; ++i)
+            dest[i] = AtomicRef<T>(base[i]).load(order);
+      }
+
+      template <typename T>
+      void atomic_store(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.store(value, order); });
+      }
+
+      template <typename T>
+      void atomic_fetch_add(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.fetch_add(value, order); });
+      }
+
+      template <typename T>
+      void atomic_fetch_sub(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.fetch_sub(value, order); });
+      }
+
+      template <typename T>
+      void atomic_fetch_and(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.fetch_and(value, order); });
+      }
+
+      template <typename T>
+      void atomic_fetch_or(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.fetch_or(value, order); });
+      }
+
+      template <typename T>
+      void atomic_fetch_xor(std::size_t offset, const T *values, std::size_t count, std::memory_order order=std::memory_order_seq_cst) {
+         this->atomic_batch<T>(offset, values, count, [order](AtomicRef<T> slot, T value) { slot.fetch_xor(value, order); });
+      }
+
       template <typename T>
       void start_with(const T* pointer, std::size_t size) {
          this->write<T>(0, pointer, size);
@@ -634,6 +1599,54 @@ namespace parfait
          this->end_with<T>(&ref);
       }
 
+      template <typename T>
+      void fill(std::size_t offset, std::size_t size, const T* pattern, std::size_t pattern_size)
+      {
+         std::size_t type_size = 1;
+
+         if constexpr (!std::is_same<typename std::remove_const<T>::type,void>::value) { type_size *= sizeof(T); }
+
+         auto pattern_bytes = pattern_size * type_size;
+         if (pattern_bytes == 0) { throw exception::ZeroSize(); }
+         if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
+         if (size == 0) { return; }
+
+         auto dest = static_cast<std::uint8_t *>(this->write_ptr(offset));
+         auto pattern_ptr = reinterpret_cast<const std::uint8_t *>(pattern);
+
+         // chunks start on pattern boundaries so the repetition lines up across them
+         this->lock();
+         parallel_for(size, parallel_grain(size, pattern_bytes), [dest, pattern_ptr, pattern_bytes](std::size_t begin, std::size_t end) {
+            kernel::fill(dest+begin, end-begin, pattern_ptr, pattern_bytes);
+         });
+         this->unlock();
+      }
+
+      template <typename T>
+      void fill(std::size_t offset, std::size_t size, const T& pattern) {
+         this->fill<T>(offset, size, &pattern, 1);
+      }
+
+      void copy_from(const Memory &source, std::size_t source_offset, std::size_t offset, std::size_t size)
+      {
+         if (source_offset+size > source._size) { throw exception::OutOfBounds(source_offset+size, source._size); }
+         if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
+         if (size == 0) { return; }
+
+         auto src = source.cast_ptr<std::uint8_t>(source_offset);
+         auto dest = static_cast<std::uint8_t *>(this->write_ptr(offset));
+
+         // two distinct objects can still describe overlapping memory (e.g., a subsection
+         // of this object), so the kernel checks for overlap before picking a copy strategy
+         this->lock_with(source, true);
+         kernel::move(dest, src, size);
+         this->unlock_with(source, true);
+      }
+
+      void move_within(std::size_t source_offset, std::size_t offset, std::size_t size) {
+         this->copy_from(*this, source_offset, offset, size);
+      }
+
       template <typename T>
       std::vector<std::size_t> search(const T* ptr, std::size_t size) const
       {
@@ -643,63 +1656,43 @@ namespace parfait
 
          auto needle_size = size * type_size;
          auto needle = reinterpret_cast<const std::uint8_t *>(ptr);
-
-         // first, build the partial table
-         std::vector<std::int32_t> partial_table(needle_size+1);
-         std::int32_t needle_index = 1;
-         std::int32_t candidate_index = 0;
-         partial_table[0] = -1;
          std::vector<std::size_t> results;
 
-         while (needle_index < needle_size)
+         if (needle_size == 0 || this->_size == 0) { return results; }
+
+         auto haystack = this->cast_ptr<std::uint8_t>();
+         auto haystack_size = this->_size;
+         auto grain = parallel_grain(haystack_size);
+
+         if (needle_size >= grain)
          {
-            if (needle[needle_index] == needle[candidate_index]) {
-               partial_table[needle_index] = partial_table[candidate_index];
-            }
-            else {
-               partial_table[needle_index] = candidate_index;
+            auto searcher = kernel::Searcher(needle, needle_size);
 
-               while (candidate_index >= 0 && needle[needle_index] != needle[candidate_index])
-                  candidate_index = partial_table[candidate_index];
-            }
-            
-            ++needle_index; ++candidate_index;
+            this->lock_shared();
+            searcher.feed(haystack, haystack_size, results);
+            this->unlock_shared();
+
+            return results;
          }
 
-         partial_table[needle_index] = candidate_index;
+         // each chunk reads needle_size-1 bytes past its end to catch matches straddling the
+         // next chunk, so it reports exactly the matches that start inside it
+         std::vector<std::vector<std::size_t>> chunk_results((haystack_size + grain - 1) / grain);
 
-         // next, search the memory
-         auto haystack = this->cast_ptr<std::uint8_t>();
-         this->lock(); 
+         this->lock_shared();
+         parallel_for(haystack_size, grain, [&](std::size_t begin, std::size_t end) {
+            auto searcher = kernel::Searcher(needle, needle_size);
+            auto &found = chunk_results[begin / grain];
 
-         needle_index = 0;
-         std::size_t i=0;
+            searcher.feed(haystack+begin, std::min(haystack_size, end+needle_size-1)-begin, found);
 
-         while (i < this->_size)
-         {
-            if (haystack[i] == needle[needle_index])
-            {
-               ++i;
-               ++needle_index;
-               
-               if (needle_index == needle_size)
-               {
-                  results.push_back(i-needle_size);
-                  needle_index = partial_table[needle_index];
-               }
-            }
-            else
-            {
-               needle_index = partial_table[needle_index];
-               
-               if (needle_index < 0) {
-                  ++i;
-                  ++needle_index;
-               }
-            }
-         }
+            for (auto &match : found)
+               match += begin;
+         });
+         this->unlock_shared();
 
-         this->unlock();
+         for (auto &found : chunk_results)
+            results.insert(results.end(), found.begin(), found.end());
 
          return results;
       }
@@ -729,6 +1722,65 @@ namespace parfait
          return this->contains<T>(&ref);
       }
 
+      std::optional<std::size_t> mismatch(std::size_t offset, const Memory &other, std::size_t other_offset, std::size_t size) const {
+         if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
+         if (other_offset+size > other._size) { throw exception::OutOfBounds(other_offset+size, other._size); }
+         if (size == 0) { return std::nullopt; }
+
+         auto left = this->cast_ptr<std::uint8_t>(offset);
+         auto right = other.cast_ptr<std::uint8_t>(other_offset);
+
+         // chunks are handed out in order, so once a difference turns up nothing after it
+         // needs comparing
+         std::atomic<std::size_t> first(size);
+
+         this->lock_shared_with(other);
+         parallel_for(size, parallel_grain(size), [left, right, &first](std::size_t begin, std::size_t end) {
+            if (begin >= first.load(std::memory_order_relaxed)) { return; }
+
+            auto found = begin + kernel::mismatch(left+begin, right+begin, end-begin);
+            if (found == end) { return; }
+
+            auto known = first.load(std::memory_order_relaxed);
+            while (found < known && !first.compare_exchange_weak(known, found, std::memory_order_relaxed)) {}
+         });
+         this->unlock_shared_with(other);
+
+         auto result = first.load();
+         if (result == size) { return std::nullopt; }
+
+         return result;
+      }
+
+      // returns the first differing offset, or nullopt if the two regions are identical.
+      // if one region is a prefix of the other, the size of the shorter region is returned.
+      std::optional<std::size_t> mismatch(const Memory &other) const {
+         auto common = std::min(this->_size, other._size);
+         auto result = this->mismatch(0, other, 0, common);
+
+         if (result.has_value() || this->_size == other._size) { return result; }
+
+         return common;
+      }
+
+      bool equals(std::size_t offset, const Memory &other, std::size_t other_offset, std::size_t size) const {
+         return !this->mismatch(offset, other, other_offset, size).has_value();
+      }
+
+      bool equals(const Memory &other) const {
+         return this->_size == other._size && !this->mismatch(other).has_value();
+      }
+
+      int compare(const Memory &other) const {
+         auto offset = this->mismatch(other);
+
+         if (!offset.has_value()) { return 0; }
+         if (*offset == this->_size) { return -1; }
+         if (*offset == other._size) { return 1; }
+
+         return (this->cast_ref<std::uint8_t>(*offset) < other.cast_ref<std::uint8_t>(*offset)) ? -1 : 1;
+      }
+
       std::pair<Memory,Memory> split_at(std::size_t midpoint) const {
          if (midpoint >= this->_size) { throw exception::OutOfBounds(midpoint, this->_size); }
 
@@ -741,25 +1793,155 @@ namespace parfait
       std::string to_hex(bool uppercase=false) const {
          const static char upper[] = "0123456789ABCDEF";
          const static char lower[] = "0123456789abcdef";
-         std::stringstream stream;
+         auto digits = (uppercase) ? upper : lower;
          auto ptr = this->cast_ptr<std::uint8_t>();
+         std::string result(this->_size*2, '0');
+         auto out = &result[0];
 
-         this->lock();
-         
-         for (std::size_t i=0; i<this->_size; ++i)
+         this->lock_shared();
+         parallel_for(this->_size, parallel_grain(this->_size), [ptr, out, digits](std::size_t begin, std::size_t end) {
+            for (std::size_t i=begin; i<end; ++i)
+            {
+               out[i*2] = digits[ptr[i] >> 4];
+               out[i*2+1] = digits[ptr[i] & 0xF];
+            }
+         });
+         this->unlock_shared();
+
+         return result;
+      }
+   };
+
+   // validates a region once and then hands out raw access to it. while any pin on an object
+   // (or on a view into it) is held, deallocating, reallocating or moving the object throws
+   // exception::Pinned, so the pointer can be used without per-access checks. a pin doesn't
+   // serialize reads and writes the way the object's accessors do, and it must not outlive
+   // the object that owns the memory.
+   template <typename T>
+   class Pin
+   {
+      friend class Memory;
+
+      Memory::Domain *domain;
+      Memory::IntervalType region;
+      T *pointer;
+      std::size_t _size;
+      const Generation *generation_slot;
+      std::uint64_t generation;
+
+      Pin(const Memory *object, std::size_t offset, std::size_t size) : domain(object->_domain), pointer(nullptr), _size(0), generation_slot(nullptr), generation(0) {
+         object->lock_shared();
+
+         if (object->pointer.c == nullptr) { object->unlock_shared(); throw exception::NullPointer(); }
+
+         if (offset+size*sizeof(T) > object->_size)
          {
-            auto left = ptr[i] >> 4;
-            auto right = ptr[i] & 0xF;
-            
-            stream << ((uppercase) ? upper[left] : lower[left])
-                   << ((uppercase) ? upper[right] : lower[right]);
+            auto object_size = object->_size;
+            object->unlock_shared();
+            throw exception::OutOfBounds(offset+size*sizeof(T), object_size);
          }
 
-         this->unlock();
+         auto region = object->interval();
+
+         try {
+            this->generation_slot = this->domain->pin(region);
+            if (this->generation_slot != nullptr) { this->generation = this->generation_slot->load(std::memory_order_acquire); }
+         }
+         catch (...) {
+            object->unlock_shared();
+            throw;
+         }
 
-         return stream.str();
+         this->region = region;
+         this->pointer = reinterpret_cast<T *>(region.low+offset);
+         this->_size = size;
+
+         object->unlock_shared();
       }
+
+      void unpin() {
+         if (this->pointer == nullptr) { return; }
+
+         this->domain->unpin(this->region, this->generation_slot, this->generation);
+         this->pointer = nullptr;
+         this->_size = 0;
+      }
+
+   public:
+      using BaseType = T;
+
+      Pin() : domain(nullptr), pointer(nullptr), _size(0), generation_slot(nullptr), generation(0) {}
+      Pin(const Pin &) = delete;
+      Pin(Pin &&other) : domain(other.domain), region(other.region), pointer(other.pointer), _size(other._size), generation_slot(other.generation_slot), generation(other.generation) {
+         other.pointer = nullptr;
+         other._size = 0;
+      }
+      ~Pin() { this->unpin(); }
+
+      Pin &operator=(const Pin &) = delete;
+      Pin &operator=(Pin &&other) {
+         if (&other == this) { return *this; }
+
+         this->unpin();
+         this->domain = other.domain;
+         this->region = other.region;
+         this->pointer = other.pointer;
+         this->_size = other._size;
+         this->generation_slot = other.generation_slot;
+         this->generation = other.generation;
+         other.pointer = nullptr;
+         other._size = 0;
+
+         return *this;
+      }
+
+      // unchecked, that's the point of pinning
+      inline T& operator[](std::size_t index) const { return this->pointer[index]; }
+
+      T& at(std::size_t index) const {
+         if (index >= this->_size) { throw exception::OutOfBounds(index, this->_size); }
+         return this->pointer[index];
+      }
+
+      inline T* data() const { return this->pointer; }
+      inline T* begin() const { return this->pointer; }
+      inline T* end() const { return this->pointer+this->_size; }
+      inline std::size_t size() const { return this->_size; }
+      inline std::size_t byte_size() const { return this->_size * sizeof(T); }
+      inline bool is_pinned() const { return this->pointer != nullptr; }
+
+      // a span that keeps checking its generation, for handing out past the pin's lifetime
+      Span<T> span() const {
+         if (this->generation_slot != nullptr && this->generation_slot->load(std::memory_order_acquire) != this->generation)
+            throw exception::InvalidPointer(this->pointer, this->byte_size());
+
+         return Span<T>(this->pointer, this->_size, this->generation_slot);
+      }
+
+      void release() { this->unpin(); }
    };
+
+   template <typename T>
+   Pin<T> Memory::pin(std::size_t offset, std::size_t size) {
+      // a mutable pin is raw write access, so it counts as a write
+      this->prepare_write();
+      return Pin<T>(this, offset, size);
+   }
+
+   template <typename T>
+   Pin<const T> Memory::pin(std::size_t offset, std::size_t size) const {
+      return Pin<const T>(this, offset, size);
+   }
+
+   template <typename T>
+   Pin<T> Memory::pin() {
+      return this->pin<T>(0, this->_size / sizeof(T));
+   }
+
+   template <typename T>
+   Pin<const T> Memory::pin() const {
+      return this->pin<T>(0, this->_size / sizeof(T));
+   }
 }
 
 #endif
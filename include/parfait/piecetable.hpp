@@ -0,0 +1,278 @@
+#ifndef __PARFAIT_PIECETABLE_H
+#define __PARFAIT_PIECETABLE_H
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include <parfait/allocated.hpp>
+
+namespace parfait
+{
+   // an editable view over an original region. edits never touch the original: inserted
+   // bytes go to an append-only buffer and the logical contents are described by a list of
+   // pieces pointing into either one. an edit costs O(edit size + number of pieces) rather
+   // than rewriting the whole buffer, and flatten() materializes the result on demand.
+   class PieceTable
+   {
+   public:
+      struct Piece
+      {
+         bool added;
+         std::size_t offset;
+         std::size_t size;
+
+         Piece(bool added, std::size_t offset, std::size_t size) : added(added), offset(offset), size(size) {}
+      };
+
+   protected:
+      Memory original;
+      AllocatedMemory<> additions;
+      std::size_t additions_size;
+      std::vector<Piece> pieces;
+      std::size_t _size;
+
+      const std::uint8_t *source(const Piece &piece, std::size_t offset=0) const {
+         if (piece.added) { return this->additions.cast_ptr<std::uint8_t>(piece.offset+offset); }
+         else { return this->original.cast_ptr<std::uint8_t>(piece.offset+offset); }
+      }
+
+      // make sure a piece boundary falls on the given offset and return the index of
+      // the piece starting there (or the piece count if the offset is the end)
+      std::size_t split(std::size_t offset) {
+         std::size_t base = 0;
+
+         for (std::size_t i=0; i<this->pieces.size(); ++i)
+         {
+            auto piece = this->pieces[i];
+
+            if (offset == base) { return i; }
+
+            if (offset < base+piece.size)
+            {
+               auto left_size = offset-base;
+
+               this->pieces[i].size = left_size;
+               this->pieces.insert(this->pieces.begin()+i+1, Piece(piece.added, piece.offset+left_size, piece.size-left_size));
+
+               return i+1;
+            }
+
+            base += piece.size;
+         }
+
+         return this->pieces.size();
+      }
+
+      std::size_t add(const std::uint8_t *data, std::size_t size) {
+         auto capacity = this->additions.size();
+         auto needed = this->additions_size + size;
+
+         // grow geometrically so a run of small inserts doesn't reallocate every time
+         if (needed > capacity)
+         {
+            auto new_capacity = std::max(needed, std::max(capacity * 2, static_cast<std::size_t>(64)));
+
+            if (capacity == 0) { this->additions.allocate(new_capacity); }
+            else { this->additions.reallocate(new_capacity); }
+         }
+
+         auto offset = this->additions_size;
+         this->additions.write<std::uint8_t>(offset, data, size);
+         this->additions_size = needed;
+
+         return offset;
+      }
+
+   public:
+      PieceTable() : additions_size(0), _size(0) {}
+      PieceTable(const Memory &original) : additions_size(0), _size(0) {
+         if (original.size() == 0) { return; }
+
+         this->original.set_memory(original.ptr(), original.size());
+         this->pieces.push_back(Piece(false, 0, original.size()));
+         this->_size = original.size();
+      }
+      PieceTable(const PieceTable &other) : additions(), additions_size(0), pieces(other.pieces), _size(other._size) {
+         if (other._size > 0 && other.original.size() > 0)
+            this->original.set_memory(other.original.ptr(), other.original.size());
+
+         if (other.additions_size > 0)
+            this->add(other.additions.ptr(), other.additions_size);
+      }
+
+      inline std::size_t size() const { return this->_size; }
+      inline bool is_empty() const { return this->_size == 0; }
+      inline const std::vector<Piece> &piece_list() const { return this->pieces; }
+
+      template <typename T>
+      void insert(std::size_t offset, const T* ptr, std::size_t size)
+      {
+         auto byte_size = ((std::is_same<T,void>::value) ? 1 : sizeof(T)) * size;
+
+         if (offset > this->_size) { throw exception::OutOfBounds(offset, this->_size); }
+         if (byte_size == 0) { return; }
+
+         auto add_offset = this->add(reinterpret_cast<const std::uint8_t *>(ptr), byte_size);
+         auto index = this->split(offset);
+
+         // sequential inserts (e.g., typing) extend the previous addition instead of adding a piece
+         if (index > 0 && this->pieces[index-1].added && this->pieces[index-1].offset+this->pieces[index-1].size == add_offset)
+            this->pieces[index-1].size += byte_size;
+         else
+            this->pieces.insert(this->pieces.begin()+index, Piece(true, add_offset, byte_size));
+
+         this->_size += byte_size;
+      }
+
+      template <typename T>
+      void insert(std::size_t offset, const T* ptr) {
+         this->insert<T>(offset, ptr, 1);
+      }
+
+      template <typename T>
+      void insert(std::size_t offset, const T& ref) {
+         this->insert<T>(offset, &ref);
+      }
+
+      template <typename T>
+      void append(const T* ptr, std::size_t size) {
+         this->insert<T>(this->_size, ptr, size);
+      }
+
+      template <typename T>
+      void append(const T* ptr) {
+         this->append<T>(ptr, 1);
+      }
+
+      template <typename T>
+      void append(const T& ref) {
+         this->append<T>(&ref);
+      }
+
+      void erase(std::size_t offset, std::size_t size)
+      {
+         if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
+         if (size == 0) { return; }
+
+         auto start = this->split(offset);
+         auto end = this->split(offset+size);
+
+         this->pieces.erase(this->pieces.begin()+start, this->pieces.begin()+end);
+         this->_size -= size;
+      }
+
+      template <typename T>
+      void read_into(std::size_t offset, T* dest, std::size_t size) const
+      {
+         auto byte_size = size * sizeof(T);
+         if (offset+byte_size > this->_size) { throw exception::OutOfBounds(offset+byte_size, this->_size); }
+
+         auto out = reinterpret_cast<std::uint8_t *>(dest);
+         std::size_t base = 0;
+
+         for (auto &piece : this->pieces)
+         {
+            if (byte_size == 0) { break; }
+
+            if (offset < base+piece.size)
+            {
+               auto inner = offset-base;
+               auto chunk = std::min(piece.size-inner, byte_size);
+
+               std::memcpy(out, this->source(piece, inner), chunk);
+               out += chunk;
+               offset += chunk;
+               byte_size -= chunk;
+            }
+
+            base += piece.size;
+         }
+      }
+
+      template <typename T>
+      std::vector<T> read(std::size_t offset, std::size_t size) const
+      {
+         std::vector<T> result(size);
+         this->read_into<T>(offset, result.data(), size);
+
+         return result;
+      }
+
+      template <typename T>
+      std::vector<std::size_t> search(const T* ptr, std::size_t size) const
+      {
+         auto needle_size = ((std::is_same<T,void>::value) ? 1 : sizeof(T)) * size;
+         std::vector<std::size_t> results;
+
+         if (needle_size == 0) { return results; }
+
+         auto searcher = kernel::Searcher(reinterpret_cast<const std::uint8_t *>(ptr), needle_size);
+
+         for (auto &piece : this->pieces)
+            searcher.feed(this->source(piece), piece.size, results);
+
+         return results;
+      }
+
+      template <typename T>
+      std::vector<std::size_t> search(const T* ptr) const {
+         return this->search<T>(ptr, 1);
+      }
+
+      template <typename T>
+      std::vector<std::size_t> search(const T& ref) const {
+         return this->search<T>(&ref);
+      }
+
+      template <typename T>
+      bool contains(const T* ptr, std::size_t size) const {
+         return this->search<T>(ptr, size).size() > 0;
+      }
+
+      template <typename T>
+      bool contains(const T* ptr) const {
+         return this->contains<T>(ptr, 1);
+      }
+
+      template <typename T>
+      bool contains(const T& ref) const {
+         return this->contains<T>(&ref);
+      }
+
+      std::string to_hex(bool uppercase=false) const {
+         const static char upper[] = "0123456789ABCDEF";
+         const static char lower[] = "0123456789abcdef";
+         std::stringstream stream;
+
+         for (auto &piece : this->pieces)
+         {
+            auto ptr = this->source(piece);
+
+            for (std::size_t i=0; i<piece.size; ++i)
+            {
+               auto left = ptr[i] >> 4;
+               auto right = ptr[i] & 0xF;
+
+               stream << ((uppercase) ? upper[left] : lower[left])
+                      << ((uppercase) ? upper[right] : lower[right]);
+            }
+         }
+
+         return stream.str();
+      }
+
+      AllocatedMemory<> flatten() const {
+         AllocatedMemory<> result;
+
+         if (this->_size == 0) { return result; }
+
+         result.allocate(this->_size);
+         this->read_into<std::uint8_t>(0, result.ptr(), this->_size);
+
+         return result;
+      }
+   };
+}
+
+#endif
@@ -108,14 +108,16 @@ namespace parfait
          return *ptr;
       }
 
+      // indexing checks the target element against the manager directly instead of
+      // declaring and destroying a temporary pointer for it
       T& operator[](std::size_t index)
       {
-         return *((*this)+index);
+         return *const_cast<T *>(this->element(index));
       }
 
       const T& operator[](std::size_t index) const
       {
-         return *((*this)+index);
+         return *this->element(index);
       }
 
       void set_memory(T *ptr) {
@@ -189,6 +191,16 @@ namespace parfait
          return Pointer<U>(this->cast_ptr<U>(), copy);
       }
 
+      const T* element(std::size_t index) const {
+         if (this->allocated) { throw exception::PointerIsAllocated(); }
+
+         auto address = reinterpret_cast<const T*>(this->interval().low+index*sizeof(T));
+         if (address == nullptr) { throw exception::NullPointer(); }
+         if (!this->manager().contains(address, sizeof(T))) { throw exception::InvalidPointer(address, sizeof(T)); }
+
+         return address;
+      }
+
       Pointer add(std::intptr_t offset) const {
          if (this->allocated) { throw exception::PointerIsAllocated(); }
          
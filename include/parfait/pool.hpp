@@ -0,0 +1,384 @@
+#ifndef __PARFAIT_POOL_H
+#define __PARFAIT_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <parfait/exception.hpp>
+
+namespace parfait
+{
+   // a flag shared between whoever starts a parallel operation and whoever wants to stop
+   // it early. copies share the same flag.
+   class Cancellation
+   {
+      std::shared_ptr<std::atomic<bool>> flag;
+
+   public:
+      Cancellation() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+      void cancel() { this->flag->store(true, std::memory_order_release); }
+      bool is_cancelled() const { return this->flag->load(std::memory_order_acquire); }
+   };
+
+   // a small work-stealing thread pool. each worker keeps its own deque, runs its newest
+   // task first and steals the oldest from the others when it runs dry. bulk operations
+   // share one pool through get_instance() rather than starting threads of their own. an
+   // executor hook hands parallel work to the caller's own scheduler instead.
+   class ThreadPool
+   {
+   public:
+      using Task = std::function<void()>;
+      using Executor = std::function<void(Task)>;
+
+      // ranges smaller than this aren't worth splitting
+      static constexpr std::size_t DefaultGrain = static_cast<std::size_t>(1) << 16;
+
+   protected:
+      struct Worker
+      {
+         std::thread thread;
+         std::mutex mutex;
+         std::deque<Task> tasks;
+      };
+
+      // the state of one parallel_for. helpers that start after the work is done find no
+      // chunks left and leave without touching the caller's body.
+      struct Loop
+      {
+         std::size_t size;
+         std::size_t grain;
+         std::size_t chunks;
+         std::atomic<std::size_t> next;
+         std::atomic<std::size_t> done;
+         std::function<void(std::size_t,std::size_t)> body;
+         const Cancellation *cancellation;
+         std::mutex mutex;
+         std::condition_variable finished;
+         std::exception_ptr error;
+         std::atomic<bool> failed;
+
+         Loop() : size(0), grain(0), chunks(0), next(0), done(0), cancellation(nullptr), failed(false) {}
+
+         bool stopped() const {
+            return this->failed.load(std::memory_order_acquire) ||
+               (this->cancellation != nullptr && this->cancellation->is_cancelled());
+         }
+
+         // claim and run chunks until there are none left
+         void run() {
+            for (;;)
+            {
+               auto chunk = this->next.fetch_add(1, std::memory_order_relaxed);
+               if (chunk >= this->chunks) { return; }
+
+               if (!this->stopped())
+               {
+                  auto begin = chunk * this->grain;
+                  auto end = std::min(this->size, begin + this->grain);
+
+                  try {
+                     this->body(begin, end);
+                  }
+                  catch (...) {
+                     std::lock_guard<std::mutex> guard(this->mutex);
+
+                     if (!this->failed.exchange(true, std::memory_order_acq_rel))
+                        this->error = std::current_exception();
+                  }
+               }
+
+               if (this->done.fetch_add(1, std::memory_order_acq_rel)+1 == this->chunks)
+               {
+                  std::lock_guard<std::mutex> guard(this->mutex);
+                  this->finished.notify_all();
+               }
+            }
+         }
+      };
+
+      static std::unique_ptr<ThreadPool> Instance;
+      static std::mutex InstanceMutex;
+      static thread_local ThreadPool *CurrentPool;
+      static thread_local std::size_t CurrentWorker;
+
+      std::vector<std::unique_ptr<Worker>> workers;
+      std::mutex sleep_mutex;
+      std::condition_variable wake;
+      std::atomic<std::size_t> pending;
+      std::atomic<std::size_t> next_worker;
+      bool stopping;
+      Executor executor;
+
+      // cpus at or past this can't be named in an affinity mask
+      static std::size_t cpu_limit() {
+#if defined(_WIN32)
+         return sizeof(DWORD_PTR) * 8;
+#elif defined(__linux__)
+         return CPU_SETSIZE;
+#else
+         return std::numeric_limits<std::size_t>::max();
+#endif
+      }
+
+      static bool pin_thread(std::thread &thread, std::size_t cpu) {
+#if defined(_WIN32)
+         return SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+         cpu_set_t set;
+         CPU_ZERO(&set);
+         CPU_SET(cpu, &set);
+         return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+         (void)thread;
+         (void)cpu;
+         return true;
+#endif
+      }
+
+      // wake every worker and wait for them to drain the queues and exit
+      void stop() {
+         {
+            std::lock_guard<std::mutex> guard(this->sleep_mutex);
+            this->stopping = true;
+         }
+
+         this->wake.notify_all();
+
+         for (auto &worker : this->workers)
+            if (worker->thread.joinable()) { worker->thread.join(); }
+      }
+
+      bool pop(std::size_t index, Task &task) {
+         auto &worker = *this->workers[index];
+         std::lock_guard<std::mutex> guard(worker.mutex);
+
+         if (worker.tasks.empty()) { return false; }
+
+         task = std::move(worker.tasks.back());
+         worker.tasks.pop_back();
+
+         return true;
+      }
+
+      bool steal(std::size_t thief, Task &task) {
+         auto count = this->workers.size();
+
+         for (std::size_t i=1; i<=count; ++i)
+         {
+            auto &victim = *this->workers[(thief + i) % count];
+            std::lock_guard<std::mutex> guard(victim.mutex);
+
+            if (victim.tasks.empty()) { continue; }
+
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+
+            return true;
+         }
+
+         return false;
+      }
+
+      // run one queued task if there is one, from our own deque first when we're a worker
+      bool run_one(std::size_t index) {
+         Task task;
+
+         if (!this->pop(index, task) && !this->steal(index, task)) { return false; }
+
+         --this->pending;
+         task();
+
+         return true;
+      }
+
+      // the threads that will pick up a loop's helper tasks, counting an executor as one
+      inline std::size_t helpers() const {
+         return (this->executor) ? std::max<std::size_t>(this->workers.size(), 1) : this->workers.size();
+      }
+
+      void work(std::size_t index) {
+         CurrentPool = this;
+         CurrentWorker = index;
+
+         for (;;)
+         {
+            if (this->run_one(index)) { continue; }
+
+            std::unique_lock<std::mutex> lock(this->sleep_mutex);
+            this->wake.wait(lock, [this]() { return this->stopping || this->pending.load() > 0; });
+
+            if (this->stopping && this->pending.load() == 0) { return; }
+         }
+      }
+
+   public:
+      // a worker per hardware thread but one, since the caller works too
+      static std::size_t default_size() {
+         auto hardware = static_cast<std::size_t>(std::thread::hardware_concurrency());
+         return (hardware > 1) ? hardware-1 : 0;
+      }
+
+      // workers are pinned round-robin to the given cpus, if any. a pool of zero workers
+      // runs everything on the calling thread. cpus are checked before any worker starts,
+      // and if the system refuses a pin the workers already started are stopped again.
+      ThreadPool(std::size_t size=ThreadPool::default_size(), const std::vector<std::size_t> &cpus={})
+         : pending(0), next_worker(0), stopping(false)
+      {
+         for (auto cpu : cpus)
+            if (cpu >= ThreadPool::cpu_limit()) { throw exception::OutOfBounds(cpu, ThreadPool::cpu_limit()); }
+
+         for (std::size_t i=0; i<size; ++i)
+            this->workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+         for (std::size_t i=0; i<size; ++i)
+         {
+            this->workers[i]->thread = std::thread(&ThreadPool::work, this, i);
+
+            if (cpus.size() > 0 && !ThreadPool::pin_thread(this->workers[i]->thread, cpus[i % cpus.size()]))
+            {
+               this->stop();
+               throw exception::AffinityFailure(cpus[i % cpus.size()]);
+            }
+         }
+      }
+      ThreadPool(const ThreadPool &) = delete;
+      ~ThreadPool() {
+         this->stop();
+      }
+
+      ThreadPool &operator=(const ThreadPool &) = delete;
+
+      static ThreadPool &get_instance() {
+         std::lock_guard<std::mutex> guard(ThreadPool::InstanceMutex);
+
+         if (ThreadPool::Instance == nullptr)
+            ThreadPool::Instance = std::unique_ptr<ThreadPool>(new ThreadPool());
+
+         return *ThreadPool::Instance;
+      }
+
+      // replace the shared pool. nothing may be running on the old one.
+      static void configure(std::size_t size, const std::vector<std::size_t> &cpus={}) {
+         std::lock_guard<std::mutex> guard(ThreadPool::InstanceMutex);
+         ThreadPool::Instance = std::unique_ptr<ThreadPool>(new ThreadPool(size, cpus));
+      }
+
+      inline std::size_t size() const { return this->workers.size(); }
+
+      void set_executor(Executor executor) { this->executor = std::move(executor); }
+
+      // a few chunks per thread so stealing can even out the load, rounded up to a multiple
+      // the caller needs its chunks to start on
+      std::size_t grain_for(std::size_t size, std::size_t multiple=1) const {
+         auto grain = std::max(DefaultGrain, size / ((this->helpers()+1) * 4));
+         if (multiple > 1) { grain += (multiple - grain % multiple) % multiple; }
+
+         return grain;
+      }
+
+      void submit(Task task) {
+         if (this->executor) { return this->executor(std::move(task)); }
+
+         if (this->workers.size() == 0) { return task(); }
+
+         // a worker keeps what it spawns, everyone else spreads tasks around
+         auto index = (CurrentPool == this) ?
+            CurrentWorker :
+            this->next_worker.fetch_add(1, std::memory_order_relaxed) % this->workers.size();
+
+         // counted before it's visible, so a thief taking it straight away can't wrap pending
+         {
+            std::lock_guard<std::mutex> guard(this->sleep_mutex);
+            ++this->pending;
+         }
+
+         {
+            std::lock_guard<std::mutex> guard(this->workers[index]->mutex);
+            this->workers[index]->tasks.push_back(std::move(task));
+         }
+
+         this->wake.notify_one();
+      }
+
+      // run body(begin, end) over [0, size) in chunks of grain, with every chunk starting at
+      // a multiple of grain. the calling thread takes chunks too and, if it's one of our
+      // workers, keeps running other tasks while it waits, so nested loops can't starve the
+      // pool. returns false if the loop was cancelled before every chunk ran. the first
+      // exception thrown by the body stops the loop and is rethrown here.
+      bool parallel_for(std::size_t size, std::function<void(std::size_t,std::size_t)> body,
+                        std::size_t grain=0, const Cancellation *cancellation=nullptr)
+      {
+         if (size == 0) { return true; }
+
+         auto helpers = this->helpers();
+
+         if (grain == 0) { grain = this->grain_for(size); }
+
+         auto chunks = (size + grain - 1) / grain;
+
+         if (chunks == 1 || helpers == 0)
+         {
+            for (std::size_t begin=0; begin<size; begin+=grain)
+            {
+               if (cancellation != nullptr && cancellation->is_cancelled()) { return false; }
+               body(begin, std::min(size, begin+grain));
+            }
+
+            return true;
+         }
+
+         auto loop = std::make_shared<Loop>();
+         loop->size = size;
+         loop->grain = grain;
+         loop->chunks = chunks;
+         loop->body = std::move(body);
+         loop->cancellation = cancellation;
+
+         for (std::size_t i=0; i<std::min(helpers, chunks-1); ++i)
+            this->submit([loop]() { loop->run(); });
+
+         loop->run();
+
+         if (CurrentPool == this)
+         {
+            while (loop->done.load(std::memory_order_acquire) < chunks)
+               if (!this->run_one(CurrentWorker)) { std::this_thread::yield(); }
+         }
+         else
+         {
+            std::unique_lock<std::mutex> lock(loop->mutex);
+            loop->finished.wait(lock, [&loop, chunks]() { return loop->done.load(std::memory_order_acquire) == chunks; });
+         }
+
+         if (loop->error) { std::rethrow_exception(loop->error); }
+
+         return !(cancellation != nullptr && cancellation->is_cancelled());
+      }
+   };
+}
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef __PARFAIT_RING_H
+#define __PARFAIT_RING_H
+
+#include <algorithm>
+
+#include <parfait/allocated.hpp>
+
+namespace parfait
+{
+   // a double-ended queue over a circular buffer. pushing and popping at either end is
+   // amortized O(1); the buffer only grows (doubling) when it's full, and the wrapped
+   // head segment is slid to the end of the new buffer rather than re-copying everything.
+   template <typename T, typename Allocator=std::allocator<T>>
+   class Ring : public AllocatedMemory<Allocator>
+   {
+      static_assert(std::is_same<T,typename Allocator::value_type>::value,
+                    "Ring type and allocator value type must be the same.");
+
+   protected:
+      std::size_t head;
+      std::size_t count;
+
+      using AllocatedMemory::allocate;
+      using AllocatedMemory::reallocate;
+      using AllocatedMemory::load_data;
+      using AllocatedMemory::load_file;
+      using AllocatedMemory::append;
+      using AllocatedMemory::insert;
+      using AllocatedMemory::erase;
+      using AllocatedMemory::split_at;
+      using AllocatedMemory::split_off;
+      using AllocatedMemory::adopt;
+      using AllocatedMemory::release;
+      using AllocatedMemory::apply;
+
+      // these all work on the raw buffer, in physical order and across unused capacity.
+      // the contents are reached through operator[], segments() and to_vec() instead.
+      using AllocatedMemory::ptr;
+      using AllocatedMemory::cast_ptr;
+      using AllocatedMemory::cast_ref;
+      using AllocatedMemory::eob;
+      using AllocatedMemory::span;
+      using AllocatedMemory::pin;
+      using AllocatedMemory::begin;
+      using AllocatedMemory::end;
+      using AllocatedMemory::subsection;
+      using AllocatedMemory::subsections;
+      using AllocatedMemory::read;
+      using AllocatedMemory::read_into;
+      using AllocatedMemory::read_view;
+      using AllocatedMemory::read_unaligned;
+      using AllocatedMemory::write;
+      using AllocatedMemory::write_unaligned;
+      using AllocatedMemory::fill;
+      using AllocatedMemory::copy_from;
+      using AllocatedMemory::move_within;
+      using AllocatedMemory::start_with;
+      using AllocatedMemory::start_with_unaligned;
+      using AllocatedMemory::end_with;
+      using AllocatedMemory::end_with_unaligned;
+      using AllocatedMemory::search;
+      using AllocatedMemory::search_unaligned;
+      using AllocatedMemory::contains;
+      using AllocatedMemory::contains_unaligned;
+      using AllocatedMemory::equals;
+      using AllocatedMemory::compare;
+      using AllocatedMemory::mismatch;
+      using AllocatedMemory::to_hex;
+      using AllocatedMemory::save;
+      using AllocatedMemory::atomic_load;
+      using AllocatedMemory::atomic_store;
+      using AllocatedMemory::atomic_exchange;
+      using AllocatedMemory::atomic_compare_exchange;
+      using AllocatedMemory::atomic_fetch_add;
+      using AllocatedMemory::atomic_fetch_sub;
+      using AllocatedMemory::atomic_fetch_and;
+      using AllocatedMemory::atomic_fetch_or;
+      using AllocatedMemory::atomic_fetch_xor;
+
+      inline std::size_t physical(std::size_t index) const {
+         auto position = this->head + index;
+         auto capacity = this->capacity();
+
+         return (position >= capacity) ? position - capacity : position;
+      }
+
+      void grow() {
+         auto capacity = this->capacity();
+         this->reserve((capacity == 0) ? DefaultCapacity : capacity * 2);
+      }
+
+   public:
+      using BaseType = T;
+      static constexpr std::size_t DefaultCapacity = 16;
+
+      Ring() : AllocatedMemory(), head(0), count(0) {}
+      Ring(std::size_t capacity) : AllocatedMemory(), head(0), count(0) {
+         this->reserve(capacity);
+      }
+      Ring(const Ring &other) : AllocatedMemory(other), head(other.head), count(other.count) {}
+
+      T& operator[](std::size_t index) {
+         if (index >= this->count) { throw exception::OutOfBounds(index, this->count); }
+         return *this->ptr(this->physical(index));
+      }
+
+      const T& operator[](std::size_t index) const {
+         if (index >= this->count) { throw exception::OutOfBounds(index, this->count); }
+         return *this->ptr(this->physical(index));
+      }
+
+      inline std::size_t size() const { return this->count; }
+      inline std::size_t capacity() const { return AllocatedMemory::size(); }
+      inline bool is_empty() const { return this->count == 0; }
+
+      void reserve(std::size_t capacity) {
+         auto old_capacity = this->capacity();
+
+         if (capacity <= old_capacity) { return; }
+
+         if (old_capacity == 0)
+         {
+            AllocatedMemory::allocate(capacity);
+            this->head = 0;
+            return;
+         }
+
+         AllocatedMemory::reallocate(capacity);
+
+         // if the contents wrapped around the old end of the buffer, slide the head
+         // segment to the end of the new one so the contents are circular again
+         if (this->head + this->count > old_capacity)
+         {
+            auto head_size = old_capacity - this->head;
+            auto new_head = capacity - head_size;
+
+            this->move_within(this->head, new_head, head_size);
+            this->head = new_head;
+         }
+      }
+
+      void clear() {
+         this->head = 0;
+         this->count = 0;
+      }
+
+      T& front() {
+         if (this->count == 0) { throw exception::ZeroSize(); }
+         return (*this)[0];
+      }
+      const T& front() const {
+         if (this->count == 0) { throw exception::ZeroSize(); }
+         return (*this)[0];
+      }
+
+      T& back() {
+         if (this->count == 0) { throw exception::ZeroSize(); }
+         return (*this)[this->count-1];
+      }
+      const T& back() const {
+         if (this->count == 0) { throw exception::ZeroSize(); }
+         return (*this)[this->count-1];
+      }
+
+      void push_back(const T& value) {
+         if (this->count == this->capacity()) { this->grow(); }
+
+         *this->ptr(this->physical(this->count)) = value;
+         ++this->count;
+      }
+
+      void push_front(const T& value) {
+         if (this->count == this->capacity()) { this->grow(); }
+
+         this->head = (this->head == 0) ? this->capacity()-1 : this->head-1;
+         *this->ptr(this->head) = value;
+         ++this->count;
+      }
+
+      std::optional<T> pop_front() {
+         if (this->count == 0) { return std::nullopt; }
+
+         auto value = *this->ptr(this->head);
+         this->head = this->physical(1);
+         --this->count;
+
+         if (this->count == 0) { this->head = 0; }
+
+         return value;
+      }
+
+      std::optional<T> pop_back() {
+         if (this->count == 0) { return std::nullopt; }
+
+         auto value = *this->ptr(this->physical(this->count-1));
+         --this->count;
+
+         if (this->count == 0) { this->head = 0; }
+
+         return value;
+      }
+
+      // the contents as at most two contiguous runs, in order, for bulk reads
+      std::pair<Span<T>,Span<T>> segments() {
+         if (this->count == 0) { return std::make_pair(Span<T>(), Span<T>()); }
+
+         auto first_size = std::min(this->count, this->capacity() - this->head);
+
+         return std::make_pair(this->span(this->head, first_size),
+                               this->span(0, this->count - first_size));
+      }
+
+      std::pair<Span<const T>,Span<const T>> segments() const {
+         if (this->count == 0) { return std::make_pair(Span<const T>(), Span<const T>()); }
+
+         auto first_size = std::min(this->count, this->capacity() - this->head);
+
+         return std::make_pair(this->span(this->head, first_size),
+                               this->span(0, this->count - first_size));
+      }
+
+      std::vector<T> to_vec(void) const {
+         auto segments = this->segments();
+         std::vector<T> result;
+
+         result.reserve(this->count);
+         result.insert(result.end(), segments.first.begin(), segments.first.end());
+         result.insert(result.end(), segments.second.begin(), segments.second.end());
+
+         return result;
+      }
+   };
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef __PARFAIT_SHARED_H
+#define __PARFAIT_SHARED_H
+
+#include <memory>
+
+#include <parfait/allocated.hpp>
+
+namespace parfait
+{
+   // an owning handle over a range of a reference-counted block. splitting or slicing a
+   // handle produces more handles into the same block without copying, and the block is
+   // freed when the last handle goes away. each handle is declared as a child of the block's
+   // region, so views of a handle are invalidated along with the block.
+   //
+   // copies share the same range (like std::shared_ptr), so writes through one handle are
+   // visible through every handle overlapping it.
+   template <typename Allocator=std::allocator<std::uint8_t>>
+   class SharedMemory : public AllocatedMemory<Allocator>
+   {
+   public:
+      using AllocatorType = typename AllocatedMemory<Allocator>::AllocatorType;
+
+   protected:
+      class Block : public Memory
+      {
+         Allocator allocator;
+         std::size_t count;
+         FillPolicy policy;
+
+      public:
+         // zeroing is left to the handle that creates the block, since it knows which
+         // bytes it's about to overwrite
+         Block(std::size_t count, FillPolicy policy, Memory::Domain &domain) : Memory(domain), count(count), policy(policy) {
+            auto ptr = this->allocator.allocate(count);
+            this->set_memory(ptr, count * sizeof(AllocatorType));
+         }
+
+         virtual ~Block() {
+            auto ptr = this->pointer.m;
+            auto size = this->_size;
+
+            this->tearing_down = true;
+            this->manager().invalidate(this);
+
+            if ((static_cast<std::uint8_t>(this->policy) & static_cast<std::uint8_t>(FillPolicy::WipeOnFree)) != 0)
+               kernel::secure_zero(ptr, size);
+
+            this->allocator.deallocate(static_cast<AllocatorType *>(ptr), this->count);
+            this->pointer.m = nullptr;
+            this->_size = 0;
+         }
+      };
+
+      std::shared_ptr<Block> block;
+
+      using AllocatedMemory::set_memory;
+      using AllocatedMemory::adopt;
+      using AllocatedMemory::release;
+
+      // handles always live in their block's domain
+      void attach(const std::shared_ptr<Block> &block, void *ptr, std::size_t size) {
+         this->_domain = &block->domain();
+         this->block = block;
+         Memory::set_memory(ptr, size);
+         this->manager().declare_child(this->block->interval(), this);
+      }
+
+   public:
+      SharedMemory() : AllocatedMemory() {}
+      SharedMemory(std::size_t size) : AllocatedMemory() {
+         this->allocate(size);
+      }
+      SharedMemory(const AllocatorType *ptr, std::size_t size) : AllocatedMemory() {
+         this->load_data<AllocatorType>(ptr, size);
+      }
+      SharedMemory(const SharedMemory &other) : AllocatedMemory() {
+         this->policy = other.policy;
+         if (other.block == nullptr) { return; }
+         this->attach(other.block, other.pointer.m, other._size);
+      }
+      virtual ~SharedMemory() {
+         // the base destructor can't dispatch back to our deallocate, so release here
+         this->tearing_down = true;
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+      }
+
+      inline bool is_unique() const { return this->block != nullptr && this->block.use_count() == 1; }
+      inline std::size_t handle_count() const { return (this->block == nullptr) ? 0 : this->block.use_count(); }
+      Memory::IntervalType block_interval() const {
+         if (this->block == nullptr) { throw exception::NotAllocated(); }
+         return this->block->interval();
+      }
+
+      void allocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+
+         auto block = std::make_shared<Block>(size, this->policy, this->manager());
+         this->zero_fill(block->ptr(), size * sizeof(AllocatorType));
+         this->attach(block, block->ptr(), size * sizeof(AllocatorType));
+      }
+
+      void deallocate() override {
+         // other handles may still be using the block, so this only drops our reference.
+         // views of this handle stay valid until the block itself is freed.
+         this->manager().check_unpinned(this);
+         Memory::set_memory(static_cast<const void *>(nullptr), 0);
+         this->block.reset();
+      }
+
+      // moves this handle to a fresh block of the new size. views over the old range stay
+      // tied to the old block and are invalidated when it is freed.
+      void reallocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c == nullptr) { return this->allocate(size); }
+
+         this->manager().check_unpinned(this);
+
+         auto new_block = std::make_shared<Block>(size, this->policy, this->manager());
+         auto new_size = size * sizeof(AllocatorType);
+         auto copy_size = std::min(this->_size, new_size);
+         auto new_ptr = reinterpret_cast<std::uint8_t *>(new_block->ptr());
+
+         std::memcpy(new_ptr, this->pointer.c, copy_size);
+         if (new_size > copy_size) { this->zero_fill(new_ptr+copy_size, new_size-copy_size); }
+
+         Memory::set_memory(static_cast<const void *>(nullptr), 0);
+         this->attach(new_block, new_ptr, new_size);
+      }
+
+      // moves this handle to a fresh block holding everything but the erased range. the old
+      // block is never written, so other handles over it keep their bytes where they were.
+      void erase(std::size_t offset, std::size_t size) override {
+         auto fixed_offset = offset * sizeof(AllocatorType);
+         auto fixed_size = size * sizeof(AllocatorType);
+         auto end_offset = fixed_offset + fixed_size;
+
+         if (end_offset > this->_size) { throw exception::OutOfBounds(end_offset, this->_size); }
+         if (size == 0) { return; }
+
+         this->manager().check_unpinned(this);
+
+         if (fixed_size == this->_size) { return this->deallocate(); }
+
+         auto new_size = this->_size - fixed_size;
+         auto new_block = std::make_shared<Block>(new_size / sizeof(AllocatorType), this->policy, this->manager());
+         auto new_ptr = reinterpret_cast<std::uint8_t *>(new_block->ptr());
+         auto old_ptr = reinterpret_cast<const std::uint8_t *>(this->pointer.c);
+
+         std::memcpy(new_ptr, old_ptr, fixed_offset);
+         std::memcpy(new_ptr+fixed_offset, old_ptr+end_offset, this->_size-end_offset);
+
+         Memory::set_memory(static_cast<const void *>(nullptr), 0);
+         this->attach(new_block, new_ptr, new_size);
+      }
+
+      // an owning handle over part of this one, sharing the same block
+      SharedMemory slice(std::size_t offset, std::size_t size) {
+         auto fixed_offset = offset * sizeof(AllocatorType);
+         auto fixed_size = size * sizeof(AllocatorType);
+
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (fixed_offset+fixed_size > this->_size) { throw exception::OutOfBounds(fixed_offset+fixed_size, this->_size); }
+
+         SharedMemory result;
+         result.policy = this->policy;
+         result.attach(this->block, Memory::ptr(fixed_offset), fixed_size);
+
+         return result;
+      }
+
+      // shrinks this handle to [0,midpoint) and returns a handle over the rest, without copying
+      SharedMemory split_off(std::size_t midpoint) {
+         auto fixed_midpoint = midpoint * sizeof(AllocatorType);
+
+         if (midpoint == 0 || fixed_midpoint >= this->_size) { throw exception::OutOfBounds(fixed_midpoint, this->_size); }
+
+         auto result = this->slice(midpoint, (this->_size - fixed_midpoint) / sizeof(AllocatorType));
+         auto base = this->pointer.m;
+
+         Memory::set_memory(static_cast<const void *>(nullptr), 0);
+         this->attach(this->block, base, fixed_midpoint);
+
+         return result;
+      }
+   };
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef __PARFAIT_SMALL_H
+#define __PARFAIT_SMALL_H
+
+#include <cstddef>
+
+#include <parfait/allocated.hpp>
+
+namespace parfait
+{
+   // an AllocatedMemory that keeps allocations of up to InlineSize bytes inside the object
+   // itself and only goes to the allocator once it grows past that. it's declared with the
+   // manager like any other allocation, so validity tracking is unchanged.
+   template <std::size_t InlineSize=64, typename Allocator=std::allocator<std::uint8_t>>
+   class SmallMemory : public AllocatedMemory<Allocator>
+   {
+      static_assert(InlineSize > 0, "Inline size must be non-zero.");
+      static_assert(alignof(typename Allocator::value_type) <= alignof(std::max_align_t),
+                    "Allocator type alignment is too strict for inline storage.");
+
+   protected:
+      alignas(alignof(std::max_align_t)) std::uint8_t storage[InlineSize];
+
+      // inline storage can't be handed over or swapped for someone else's block
+      using AllocatedMemory::adopt;
+      using AllocatedMemory::release;
+
+   public:
+      using AllocatorType = typename AllocatedMemory<Allocator>::AllocatorType;
+      static constexpr std::size_t InlineCapacity = InlineSize / sizeof(AllocatorType);
+
+      SmallMemory() : AllocatedMemory() {}
+      SmallMemory(std::size_t size) : AllocatedMemory() {
+         this->allocate(size);
+      }
+      SmallMemory(const AllocatorType *ptr, std::size_t size) : AllocatedMemory() {
+         this->load_data<AllocatorType>(ptr, size);
+      }
+      SmallMemory(const SmallMemory &other) : AllocatedMemory() {
+         this->_domain = other._domain;
+         this->policy = other.policy;
+         if (other.pointer.c == nullptr) { return; }
+
+         this->allocate(other.size());
+         std::memcpy(this->pointer.m, other.ptr(), this->_size);
+      }
+      virtual ~SmallMemory() {
+         // the base destructor can't dispatch back to our deallocate, so release here
+         this->tearing_down = true;
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+      }
+
+      inline bool is_inline() const { return this->pointer.c == static_cast<const void *>(this->storage); }
+
+      void allocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+
+         auto byte_size = size * sizeof(AllocatorType);
+
+         if (byte_size > InlineSize) { return AllocatedMemory::allocate(size); }
+
+         this->zero_fill(this->storage, byte_size);
+         this->set_memory(static_cast<void *>(this->storage), byte_size);
+      }
+
+      void deallocate() override {
+         if (!this->is_inline()) { return AllocatedMemory::deallocate(); }
+
+         this->manager().invalidate(this);
+         this->wipe(this->storage, this->_size);
+         this->set_memory(static_cast<const void *>(nullptr), 0);
+      }
+
+      void reallocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c == nullptr) { return this->allocate(size); }
+
+         this->manager().check_unpinned(this);
+
+         // once spilled, stay on the heap rather than bouncing back and forth
+         if (!this->is_inline()) { return AllocatedMemory::reallocate(size); }
+
+         auto new_size = size * sizeof(AllocatorType);
+         auto old_size = this->_size;
+
+         if (new_size == old_size) { return; }
+
+         if (new_size <= InlineSize)
+         {
+            if (new_size > old_size) { this->zero_fill(&this->storage[old_size], new_size-old_size); }
+            if (new_size < old_size) { this->wipe(&this->storage[new_size], old_size-new_size); }
+
+            this->manager().resize(this, new_size);
+            return;
+         }
+
+         auto new_ptr = this->allocator.allocate(size);
+         std::memcpy(new_ptr, this->storage, old_size);
+         this->zero_fill(reinterpret_cast<std::uint8_t *>(new_ptr)+old_size, new_size-old_size);
+
+         this->manager().move(this, new_ptr, new_size);
+         this->wipe(this->storage, old_size);
+      }
+   };
+
+   // an array that keeps up to N elements inline and spills onto the heap past that
+   template <typename T, std::size_t N>
+   class InlineArray : public SmallMemory<N*sizeof(T), std::allocator<T>>
+   {
+   protected:
+      using SmallMemory::load_data;
+      using SmallMemory::load_file;
+      using SmallMemory::split_off;
+
+   public:
+      using BaseType = T;
+
+      InlineArray() : SmallMemory() {}
+      InlineArray(std::size_t size) : SmallMemory(size) {}
+      InlineArray(const T *ptr, std::size_t size) : SmallMemory(ptr, size) {}
+      InlineArray(const InlineArray &other) : SmallMemory(other) {}
+
+      T& operator[](std::size_t offset) { return *this->ptr(offset); }
+      const T& operator[](std::size_t offset) const { return *this->ptr(offset); }
+
+      T& front() { return *this->ptr(); }
+      const T& front() const { return *this->ptr(); }
+
+      T& back() {
+         if (this->size() == 0) { throw exception::ZeroSize(); }
+         return *this->ptr(this->size()-1);
+      }
+      const T& back() const {
+         if (this->size() == 0) { throw exception::ZeroSize(); }
+         return *this->ptr(this->size()-1);
+      }
+
+      void push_back(const T& value) {
+         this->append<T>(value);
+      }
+
+      std::optional<T> pop_back() {
+         if (this->size() == 0) { return std::nullopt; }
+
+         auto value = (*this)[this->size()-1];
+         this->erase(this->size()-1, 1);
+
+         return value;
+      }
+
+      std::vector<T> to_vec(void) const {
+         if (this->size() == 0) { return std::vector<T>(); }
+         return std::vector<T>(this->ptr(), this->ptr()+this->size());
+      }
+   };
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef __PARFAIT_SPAN_H
+#define __PARFAIT_SPAN_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <parfait/exception.hpp>
+#include <parfait/iterator.hpp>
+
+namespace parfait
+{
+   // a non-owning, bounds-checked view over memory owned by something else. spans are
+   // not declared with the manager: they are validated once when they're handed out and
+   // afterward only compare the generation of the region they came from, which the manager
+   // bumps whenever that region is invalidated or moved.
+   template <typename T>
+   class Span
+   {
+      template <typename U>
+      friend class Span;
+
+   protected:
+      T *pointer;
+      std::size_t _size;
+      const Generation *generation_slot;
+      std::uint64_t generation;
+
+   public:
+      using BaseType = T;
+
+      Span() : pointer(nullptr), _size(0), generation_slot(nullptr), generation(0) {}
+      Span(T *pointer, std::size_t size, const Generation *generation_slot=nullptr)
+         : pointer(pointer),
+           _size(size),
+           generation_slot(generation_slot),
+           generation((generation_slot == nullptr) ? 0 : generation_slot->load(std::memory_order_acquire)) {}
+
+      template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+      Span(const Span<U> &other) : pointer(other.pointer),
+                                   _size(other._size),
+                                   generation_slot(other.generation_slot),
+                                   generation(other.generation) {}
+
+      T& operator[](std::size_t index) const {
+         if (index >= this->_size) { throw exception::OutOfBounds(index, this->_size); }
+         this->validate();
+         return this->pointer[index];
+      }
+
+      inline bool is_valid() const {
+         return this->generation_slot == nullptr || this->generation_slot->load(std::memory_order_acquire) == this->generation;
+      }
+
+      void validate() const {
+         if (!this->is_valid()) { throw exception::InvalidPointer(this->pointer, this->byte_size()); }
+      }
+
+      inline T *data() const { return this->pointer; }
+      inline std::size_t size() const { return this->_size; }
+      inline std::size_t byte_size() const { return this->_size * sizeof(T); }
+      inline bool is_empty() const { return this->_size == 0; }
+      // iteration checks the generation once up front; in debug builds the iterators
+      // also keep checking bounds and generation on every dereference
+      inline Iterator<T> begin() const {
+         this->validate();
+         return Iterator<T>(this->pointer, this->pointer, this->pointer+this->_size, this->generation_slot, this->generation);
+      }
+      inline Iterator<T> end() const {
+         return Iterator<T>(this->pointer+this->_size, this->pointer, this->pointer+this->_size, this->generation_slot, this->generation);
+      }
+
+      T& front() const {
+         if (this->_size == 0) { throw exception::ZeroSize(); }
+         return (*this)[0];
+      }
+
+      T& back() const {
+         if (this->_size == 0) { throw exception::ZeroSize(); }
+         return (*this)[this->_size-1];
+      }
+
+      Span subspan(std::size_t offset, std::size_t size) const {
+         if (offset+size > this->_size) { throw exception::OutOfBounds(offset+size, this->_size); }
+
+         auto result = *this;
+         result.pointer += offset;
+         result._size = size;
+
+         return result;
+      }
+
+      std::vector<typename std::remove_const<T>::type> to_vec() const {
+         this->validate();
+         return std::vector<typename std::remove_const<T>::type>(this->begin(), this->end());
+      }
+   };
+}
+
+#endif
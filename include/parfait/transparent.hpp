@@ -10,31 +10,68 @@ namespace parfait
    {
    protected:
       bool allocated;
+      bool shared;
+
+      // an allocated object can be shared: it logically owns its contents but still aliases
+      // the bytes it was consumed or copied from. the first write through its interface (or
+      // the source region changing) makes it take its own copy.
+      void share(const void *ptr, std::size_t size) {
+         AllocatedMemory::set_memory(ptr, size);
+         this->allocated = true;
+         this->shared = true;
+         this->manager().borrow(this);
+      }
+
+      void unshare() {
+         this->manager().release(this);
+         this->shared = false;
+         this->allocated = false;
+      }
+
+      void prepare_write() override {
+         if (this->shared) { this->detach(); }
+         else { AllocatedMemory::prepare_write(); }
+      }
+
+      void detach() override {
+         if (!this->shared) { return; }
+
+         auto borrowed = this->pointer.m;
+         auto size = this->_size;
+
+         this->unshare();
+         this->load_data<void>(borrowed, size);
+      }
       
    public:
-      TransparentMemory() : allocated(false), AllocatedMemory() {}
-      TransparentMemory(std::size_t size) : allocated(true), AllocatedMemory(size) {}
-      TransparentMemory(void *ptr, std::size_t size, bool copy=false) : allocated(false), AllocatedMemory() {
+      TransparentMemory() : allocated(false), shared(false), AllocatedMemory() {}
+      TransparentMemory(std::size_t size) : allocated(true), shared(false), AllocatedMemory(size) {}
+      TransparentMemory(void *ptr, std::size_t size, bool copy=false) : allocated(false), shared(false), AllocatedMemory() {
          if (copy) { this->load_data(ptr, size); }
          else { this->set_memory(ptr, size); }
       }
-      TransparentMemory(const void *ptr, std::size_t size, bool copy=false) : allocated(false), AllocatedMemory() {
+      TransparentMemory(const void *ptr, std::size_t size, bool copy=false) : allocated(false), shared(false), AllocatedMemory() {
          if (copy) { this->load_data(ptr, size); }
          else { this->set_memory(ptr, size); }
       }
-      TransparentMemory(const TransparentMemory &other) : allocated(other.allocated) {
-         if (other.allocated) {
-            this->allocate(other.size());
-            std::memcpy(this->pointer.m, other.ptr(), this->_size);
-         }
-         else { this->set_memory(other.ptr(), other.size()); }
+      TransparentMemory(const TransparentMemory &other) : allocated(false), shared(false) {
+         // a borrower has to live in the owner's domain for the owner to find it
+         this->_domain = other._domain;
+         this->policy = other.policy;
+         if (other.allocated) { this->share(other.ptr(), other.byte_size()); }
+         else { this->set_memory(other.ptr(), other.byte_size()); }
       }
       virtual ~TransparentMemory() {
+         // once released, no owner can be detaching us while we tear down. this waits out a
+         // detach that's already running, so it can't go by the shared flag that detach clears.
+         this->manager().release(this);
+         this->tearing_down = true;
          if (this->allocated) { this->deallocate(); }
          else if (this->pointer.c != nullptr) { this->manager().destroy(this); this->pointer.m = nullptr; this->_size = 0; }
       }
 
       inline bool is_allocated() const { return this->allocated; }
+      inline bool is_shared() const { return this->shared; }
 
       void set_memory(void *ptr, std::size_t size) {
          if (this->allocated) { this->deallocate(); }
@@ -52,16 +89,19 @@ namespace parfait
 
       TransparentMemory subsection(std::size_t offset, std::size_t size) {
          auto subsection = AllocatedMemory::subsection(offset, size);
+         Memory::Domain::Scope scope(this->manager());
          return TransparentMemory(subsection.ptr(), subsection.size());
       }
 
       const TransparentMemory subsection(std::size_t offset, std::size_t size) const {
          auto subsection = AllocatedMemory::subsection(offset, size);
+         Memory::Domain::Scope scope(this->manager());
          return TransparentMemory(subsection.ptr(), subsection.size());
       }
 
       std::pair<TransparentMemory,TransparentMemory> split_at(std::size_t midpoint) const {
          auto pair = AllocatedMemory::split_at(midpoint);
+         Memory::Domain::Scope scope(this->manager());
          return std::make_pair(TransparentMemory(pair.first.cast_ptr<AllocatedMemory::AllocatorType *>(),
                                                  pair.first.size() / sizeof(AllocatedMemory::AllocatorType)),
                                TransparentMemory(pair.second.cast_ptr<AllocatedMemory::AllocatorType *>(),
@@ -77,16 +117,63 @@ namespace parfait
       }
 
       void deallocate() {
+         if (this->shared)
+         {
+            // the bytes belong to someone else, just let go of them
+            this->unshare();
+            AllocatedMemory::set_memory(static_cast<const void *>(nullptr), 0);
+            return;
+         }
+
          AllocatedMemory::deallocate();
          this->allocated = false;
       }
 
       void reallocate(std::size_t size) {
          if (!this->allocated) { return this->allocate(size); }
+
+         if (this->shared)
+         {
+            // copy straight into the resized allocation instead of detaching and then resizing
+            if (size == 0) { throw exception::ZeroSize(); }
+
+            auto borrowed = this->pointer.c;
+            auto copy_size = std::min(this->_size, size * this->element_size());
+
+            this->unshare();
+            AllocatedMemory::set_memory(static_cast<const void *>(nullptr), 0);
+            AllocatedMemory::allocate(size);
+            this->allocated = true;
+            std::memcpy(this->pointer.m, borrowed, copy_size);
+            return;
+         }
+
          AllocatedMemory::reallocate(size);
          this->allocated = true;
       }
 
+      using AllocatedMemory::adopt;
+
+      void adopt(typename AllocatedMemory::AllocatorType *ptr, std::size_t size, typename AllocatedMemory::Deleter deleter) override {
+         if (this->allocated) { this->deallocate(); }
+         else if (this->pointer.c != nullptr) { this->set_memory(reinterpret_cast<const void *>(nullptr), 0); }
+
+         AllocatedMemory::adopt(ptr, size, std::move(deleter));
+         this->allocated = true;
+      }
+
+      std::pair<typename AllocatedMemory::ReleasedPtr,std::size_t> release() override {
+         if (!this->allocated) { throw exception::NotAllocated(); }
+
+         // only a block we own outright can be handed over
+         if (this->shared) { this->detach(); }
+
+         auto result = AllocatedMemory::release();
+         this->allocated = false;
+
+         return result;
+      }
+
       template <typename T>
       void append(const T* ptr, std::size_t size) {
          if (this->pointer.c != nullptr && !this->allocated) { throw exception::NotAllocated(); }
@@ -121,13 +208,25 @@ namespace parfait
 
       TransparentMemory split_off(std::size_t midpoint) {
          if (!this->allocated) { throw exception::NotAllocated(); }
-         auto result = AllocatedMemory::split_off(midpoint);
-         return TransparentMemory(result.ptr(), result.size(), true);
+
+         // copy the right half straight into the result rather than through an intermediate
+         // AllocatedMemory. for a split with no copy at all, see SharedMemory.
+         auto fixed_midpoint = midpoint * this->element_size();
+         if (fixed_midpoint >= this->_size) { throw exception::OutOfBounds(fixed_midpoint, this->_size); }
+
+         TransparentMemory result(Memory::ptr(fixed_midpoint), this->_size - fixed_midpoint, true);
+         this->reallocate(midpoint);
+
+         return result;
       }
 
+      // take ownership of the borrowed region without copying it yet. the copy happens the
+      // first time this object or the region's owner is written through its interface (write,
+      // fill, append, insert, erase, reallocate or a mutable pin), or when the region is about
+      // to be invalidated or relocated. writes through raw pointers from ptr() aren't tracked.
       void consume() {
-         if (this->is_allocated()) { return; }
-         this->load_data<void>(this->pointer.m, this->_size);
+         if (this->is_allocated() || this->pointer.c == nullptr) { return; }
+         this->share(this->pointer.c, this->_size);
       }
    };
 }
@@ -76,11 +76,13 @@ namespace parfait
       const Pointer<VariadicType> variadic_eob() const { return this->variadic_ptr()+this->variadic_size(); }
       Array<VariadicType> variadic_array() { return Array<VariadicType>(this->variadic_ptr().ptr(), this->variadic_size()); }
       const Array<VariadicType> variadic_array() const { return Array<VariadicType>(this->variadic_ptr().ptr(), this->variadic_size()); }
+      Span<VariadicType> variadic_span() { return TransparentMemory::span<VariadicType>(VariadicOffset, this->variadic_size()); }
+      Span<const VariadicType> variadic_span() const { return TransparentMemory::span<VariadicType>(VariadicOffset, this->variadic_size()); }
 
-      // the reference returned in this function is not owned by the array that gets disposed upon return--
+      // the reference returned in this function is not owned by the span that gets disposed upon return--
       // rather, it is a reference to the memory owned by the pointer/size pair of the Variadic pointer
-      VariadicType &get(std::size_t offset) { return this->variadic_array()[offset]; }
-      const VariadicType &get(std::size_t offset) const { return this->variadic_array()[offset]; }
+      VariadicType &get(std::size_t offset) { return this->variadic_span()[offset]; }
+      const VariadicType &get(std::size_t offset) const { return this->variadic_span()[offset]; }
    };
 }
 
@@ -0,0 +1,129 @@
+#ifndef __PARFAIT_VIRTUAL_H
+#define __PARFAIT_VIRTUAL_H
+
+#include <parfait/allocated.hpp>
+#include <parfait/vm.hpp>
+
+namespace parfait
+{
+   // a byte buffer that reserves a large range of address space up front and commits pages
+   // as it grows. the base address never changes, so growing never copies and subsections,
+   // spans and pointers into the buffer stay valid. shrinking gives whole pages back to the
+   // operating system.
+   class VirtualMemory : public AllocatedMemory<>
+   {
+   protected:
+      std::size_t reserved;
+      std::size_t committed;
+
+      // the reservation is ours, so blocks can't be adopted into it or released from it
+      using AllocatedMemory::adopt;
+      using AllocatedMemory::release;
+
+   public:
+      static constexpr std::size_t DefaultReserve = (sizeof(void *) == 8) ?
+         (static_cast<std::size_t>(1) << 36) :
+         (static_cast<std::size_t>(1) << 28);
+
+      VirtualMemory(std::size_t reserve=DefaultReserve) : AllocatedMemory(), committed(0) {
+         if (reserve == 0) { throw exception::ZeroSize(); }
+         this->reserved = vm::round_up(reserve, vm::page_size());
+      }
+      VirtualMemory(std::size_t size, std::size_t reserve) : VirtualMemory(reserve) {
+         this->allocate(size);
+      }
+      VirtualMemory(const VirtualMemory &other) : AllocatedMemory(), reserved(other.reserved), committed(0) {
+         this->_domain = other._domain;
+         this->policy = other.policy;
+         if (other.pointer.c == nullptr) { return; }
+
+         this->allocate(other.size());
+         std::memcpy(this->pointer.m, other.ptr(), this->_size);
+      }
+      virtual ~VirtualMemory() {
+         // the base destructor can't dispatch back to our deallocate, so release here
+         this->tearing_down = true;
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+      }
+
+      inline std::size_t reserved_size() const { return this->reserved; }
+      inline std::size_t committed_size() const { return this->committed; }
+
+      void allocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (size > this->reserved) { throw exception::ReservationExceeded(size, this->reserved); }
+         if (this->pointer.c != nullptr) { this->deallocate(); }
+
+         auto ptr = vm::reserve(this->reserved);
+         auto commit_size = vm::round_up(size, vm::page_size());
+
+         try {
+            vm::commit(ptr, commit_size);
+         }
+         catch (...) {
+            vm::release(ptr, this->reserved);
+            throw;
+         }
+
+         // freshly committed pages are already zero
+         this->committed = commit_size;
+         this->set_memory(ptr, size);
+      }
+
+      void deallocate() override {
+         // unmapped pages are zeroed by the operating system before anyone else sees
+         // them, so there's nothing to wipe here
+         auto ptr = this->pointer.m;
+
+         this->manager().invalidate(this);
+         this->set_memory(static_cast<const void *>(nullptr), 0);
+
+         vm::release(ptr, this->reserved);
+         this->committed = 0;
+      }
+
+      void reallocate(std::size_t size) override {
+         if (size == 0) { throw exception::ZeroSize(); }
+         if (this->pointer.c == nullptr) { return this->allocate(size); }
+         if (size > this->reserved) { throw exception::ReservationExceeded(size, this->reserved); }
+
+         this->manager().check_unpinned(this);
+
+         auto base = reinterpret_cast<std::uint8_t *>(this->pointer.m);
+         auto old_size = this->_size;
+         auto commit_size = vm::round_up(size, vm::page_size());
+
+         if (size == old_size) { return; }
+
+         if (size > old_size)
+         {
+            // only the part of the last page we already had can hold stale bytes
+            auto stale_end = std::min(size, this->committed);
+            if (stale_end > old_size) { this->zero_fill(base+old_size, stale_end-old_size); }
+
+            if (commit_size > this->committed)
+            {
+               vm::commit(base+this->committed, commit_size-this->committed);
+               this->committed = commit_size;
+            }
+
+            this->manager().resize(this, size);
+            return;
+         }
+
+         this->manager().resize(this, size);
+
+         // pages past the new end are discarded outright, only the rest of the last kept
+         // page needs wiping
+         this->wipe(base+size, std::min(old_size, commit_size)-size);
+
+         if (commit_size < this->committed)
+         {
+            vm::decommit(base+commit_size, this->committed-commit_size);
+            this->committed = commit_size;
+         }
+      }
+   };
+}
+
+#endif
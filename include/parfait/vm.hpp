@@ -0,0 +1,136 @@
+#ifndef __PARFAIT_VM_H
+#define __PARFAIT_VM_H
+
+#include <cstddef>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <parfait/exception.hpp>
+
+#if defined(__linux__)
+#define PARFAIT_VM_REMAP
+#endif
+
+namespace parfait
+{
+namespace vm
+{
+   inline std::size_t page_size() {
+#if defined(_WIN32)
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      return static_cast<std::size_t>(info.dwPageSize);
+#else
+      return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+   }
+
+   inline std::size_t round_up(std::size_t size, std::size_t granularity) {
+      return ((size + granularity - 1) / granularity) * granularity;
+   }
+
+   // reserve address space without backing it with memory
+   inline void *reserve(std::size_t size) {
+#if defined(_WIN32)
+      auto ptr = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+      if (ptr == nullptr) { throw exception::MappingFailure(size); }
+#else
+      auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+      flags |= MAP_NORESERVE;
+#endif
+      auto ptr = mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+      if (ptr == MAP_FAILED) { throw exception::MappingFailure(size); }
+#endif
+
+      return ptr;
+   }
+
+   // back part of a reservation with zeroed, writable pages
+   inline void commit(void *ptr, std::size_t size) {
+      if (size == 0) { return; }
+
+#if defined(_WIN32)
+      if (VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == nullptr) { throw exception::MappingFailure(size); }
+#else
+      if (mprotect(ptr, size, PROT_READ | PROT_WRITE) != 0) { throw exception::MappingFailure(size); }
+#endif
+   }
+
+   // give the pages back to the operating system but keep the address range reserved.
+   // the next commit of the range sees zeroed pages again.
+   inline void decommit(void *ptr, std::size_t size) {
+      if (size == 0) { return; }
+
+#if defined(_WIN32)
+      if (VirtualFree(ptr, size, MEM_DECOMMIT) == 0) { throw exception::MappingFailure(size); }
+#elif defined(__linux__)
+      if (madvise(ptr, size, MADV_DONTNEED) != 0) { throw exception::MappingFailure(size); }
+      if (mprotect(ptr, size, PROT_NONE) != 0) { throw exception::MappingFailure(size); }
+#else
+      // MADV_DONTNEED doesn't discard anonymous pages everywhere, so map fresh ones over the range
+      auto flags = MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+      flags |= MAP_NORESERVE;
+#endif
+      if (mmap(ptr, size, PROT_NONE, flags, -1, 0) == MAP_FAILED) { throw exception::MappingFailure(size); }
+#endif
+   }
+
+   // reserve and commit in one go
+   inline void *map(std::size_t size) {
+#if defined(_WIN32)
+      auto ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+      if (ptr == nullptr) { throw exception::MappingFailure(size); }
+#else
+      auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr == MAP_FAILED) { throw exception::MappingFailure(size); }
+#endif
+
+      return ptr;
+   }
+
+#if defined(PARFAIT_VM_REMAP)
+   // resize a mapping by moving its page table entries rather than copying its contents.
+   // the result may be at a different address.
+   inline void *remap(void *ptr, std::size_t old_size, std::size_t new_size) {
+      auto result = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+      if (result == MAP_FAILED) { throw exception::MappingFailure(new_size); }
+
+      return result;
+   }
+#endif
+
+   // ask for transparent huge pages over the range. this is only a hint, so it quietly
+   // does nothing where huge pages aren't available.
+   inline bool advise_huge_pages(void *ptr, std::size_t size) {
+#if defined(MADV_HUGEPAGE)
+      return madvise(ptr, size, MADV_HUGEPAGE) == 0;
+#else
+      (void)ptr;
+      (void)size;
+      return false;
+#endif
+   }
+
+   inline void release(void *ptr, std::size_t size) {
+#if defined(_WIN32)
+      if (VirtualFree(ptr, 0, MEM_RELEASE) == 0) { throw exception::MappingFailure(size); }
+#else
+      if (munmap(ptr, size) != 0) { throw exception::MappingFailure(size); }
+#endif
+   }
+}}
+
+#endif
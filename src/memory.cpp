@@ -3,3 +3,5 @@
 using namespace parfait;
 
 std::unique_ptr<Memory::Manager> Memory::Manager::Instance;
+std::once_flag Memory::Manager::InstanceFlag;
+thread_local Memory::Manager *Memory::Manager::Current = nullptr;
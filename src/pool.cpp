@@ -0,0 +1,8 @@
+#include <parfait.hpp>
+
+using namespace parfait;
+
+std::unique_ptr<ThreadPool> ThreadPool::Instance;
+std::mutex ThreadPool::InstanceMutex;
+thread_local ThreadPool *ThreadPool::CurrentPool = nullptr;
+thread_local std::size_t ThreadPool::CurrentWorker = 0;
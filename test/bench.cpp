@@ -0,0 +1,166 @@
+#include <parfait.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace parfait;
+
+#define BENCH_REPEAT 5
+
+// best-of-N wall time in milliseconds, so one-off page faults and scheduling noise don't dominate
+double time_best(const std::function<void()> &body) {
+   double best = 0.0;
+
+   for (int i=0; i<BENCH_REPEAT; ++i)
+   {
+      auto start = std::chrono::steady_clock::now();
+      body();
+      auto end = std::chrono::steady_clock::now();
+      auto elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+
+      if (i == 0 || elapsed < best) { best = elapsed; }
+   }
+
+   return best;
+}
+
+void report(const std::string &group, const std::string &name, double ms) {
+   std::cout << std::left << std::setw(24) << group
+             << std::setw(28) << name
+             << std::right << std::setw(12) << std::fixed << std::setprecision(3) << ms << " ms" << std::endl;
+}
+
+// scanning the same data held by different allocators: a linear sum, a random gather
+// (which mostly measures TLB reach) and a byte search through the kernels
+template <typename Allocator>
+void bench_scan(const std::string &name, std::size_t count, const std::vector<std::uint32_t> &indexes) {
+   AllocatedMemory<Allocator> buffer(count);
+   auto span = buffer.span();
+
+   for (std::size_t i=0; i<count; ++i)
+      span[i] = static_cast<std::uint32_t>(i * 2654435761u);
+
+   volatile std::uint64_t sink = 0;
+
+   report(name, "linear sum", time_best([&]() {
+      std::uint64_t sum = 0;
+      for (auto value : span) { sum += value; }
+      sink = sum;
+   }));
+
+   report(name, "random gather", time_best([&]() {
+      std::uint64_t sum = 0;
+      auto data = span.data();
+      for (auto index : indexes) { sum += data[index]; }
+      sink = sum;
+   }));
+
+   std::uint8_t needle[] = { 0xFE, 0xED, 0xFA, 0xCE, 0xFE, 0xED };
+
+   report(name, "search (missing)", time_best([&]() {
+      sink = buffer.template search<std::uint8_t>(needle, sizeof(needle)).size();
+   }));
+
+   (void)sink;
+}
+
+// the manager query behind every checked access, with the domain holding the given number
+// of disjoint regions. each runs in a domain of its own so earlier benchmarks don't add to it.
+void bench_lookup(std::size_t regions, const std::vector<std::uint32_t> &indexes) {
+   const std::size_t region_size = 16;
+   std::vector<std::uint8_t> backing(regions * region_size);
+   Memory::Domain domain;
+   std::deque<Memory> objects;
+
+   {
+      Memory::Domain::Scope scope(domain);
+
+      for (std::size_t i=0; i<regions; ++i)
+         objects.emplace_back(&backing[i * region_size], region_size);
+   }
+
+   auto group = "lookup (" + std::to_string(regions) + ")";
+   volatile std::uintptr_t sink = 0;
+
+   report(group, "is_valid", time_best([&]() {
+      std::uintptr_t valid = 0;
+      for (auto index : indexes) { valid += objects[index % regions].is_valid(); }
+      sink = valid;
+   }));
+
+   report(group, "ptr", time_best([&]() {
+      std::uintptr_t sum = 0;
+      for (auto index : indexes) { sum += reinterpret_cast<std::uintptr_t>(static_cast<const Memory &>(objects[index % regions]).ptr()); }
+      sink = sum;
+   }));
+
+   // nothing's left to unregister object by object
+   domain.teardown();
+
+   (void)sink;
+}
+
+// declaring and dropping many small views over one image, one at a time and as a batch
+void bench_views(std::size_t views) {
+   const std::size_t view_size = 32;
+   std::vector<std::uint8_t> backing(views * view_size);
+   Memory::Domain domain;
+   Memory::Domain::Scope scope(domain);
+   Memory image(backing.data(), backing.size());
+   std::vector<std::pair<std::size_t,std::size_t>> ranges;
+
+   for (std::size_t i=0; i<views; ++i)
+      ranges.push_back(std::make_pair(i * view_size, view_size));
+
+   auto group = "views (" + std::to_string(views) + ")";
+
+   report(group, "subsection", time_best([&]() {
+      std::vector<Memory> objects;
+      objects.reserve(views);
+
+      for (auto &range : ranges)
+         objects.push_back(image.subsection(range.first, range.second));
+   }));
+
+   report(group, "subsections", time_best([&]() {
+      auto objects = image.subsections(ranges);
+      Memory::destroy_subsections(objects);
+   }));
+}
+
+int main(int argc, char **argv) {
+   // 256MB of elements by default, large enough that the page tables stop fitting in the TLB
+   std::size_t count = (argc > 1) ? std::stoull(argv[1]) : (static_cast<std::size_t>(64) << 20);
+   std::vector<std::uint32_t> indexes(1 << 22);
+   std::mt19937 rng(0x5EED);
+
+   for (auto &index : indexes)
+      index = static_cast<std::uint32_t>(rng() % count);
+
+   std::cout << "Scanning " << count << " uint32 elements, best of " << BENCH_REPEAT << " runs." << std::endl;
+
+   bench_scan<std::allocator<std::uint32_t>>("std::allocator", count, indexes);
+   bench_scan<AlignedAllocator<std::uint32_t, alignment::CacheLine, 0>>("aligned (64)", count, indexes);
+   bench_scan<AlignedAllocator<std::uint32_t, alignment::Page, 0>>("aligned (page)", count, indexes);
+   bench_scan<AlignedAllocator<std::uint32_t, alignment::CacheLine>>("aligned + huge pages", count, indexes);
+
+   std::cout << "Looking up " << indexes.size() << " random regions, best of " << BENCH_REPEAT << " runs." << std::endl;
+
+   for (std::size_t regions : { 1000, 100000, 1000000 })
+      bench_lookup(regions, indexes);
+
+   std::cout << "Declaring views over one image, best of " << BENCH_REPEAT << " runs." << std::endl;
+
+   for (std::size_t views : { 1000, 30000 })
+      bench_views(views);
+
+   return 0;
+}
@@ -1,10 +1,30 @@
 #include <framework.hpp>
 #include <parfait.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <new>
+#include <thread>
 
 using namespace parfait;
 
+// every heap allocation the test binary makes, so a test can check a path makes none
+static std::atomic<std::size_t> heap_allocations(0);
+
+void *operator new(std::size_t size) {
+   ++heap_allocations;
+
+   if (auto ptr = std::malloc((size == 0) ? 1 : size)) { return ptr; }
+
+   throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
 int test_memory()
 {
    INIT();
@@ -31,7 +51,21 @@ int test_memory()
    ASSERT(subslice_4.cast_ref<std::uint32_t>() == 0xEFBEADDE);
 
    ASSERT(std::memcmp(slice.read<std::uint8_t>(8, 4).data(), "\xde\xad\xbe\xa7", 4) == 0);
-   ASSERT(std::memcmp(slice.read<std::uint8_t>(0xC, 4).data(), "\xde\xfa\xce\xd1", 4) == 0);
+   ASSERT(std::memcmp(slice.read_view<std::uint8_t>(0xC, 4).data(), "\xde\xfa\xce\xd1", 4) == 0);
+   ASSERT(slice.read_view<std::uint32_t>(4, 2)[1] == 0xA7BEADDE);
+   ASSERT_THROWS(slice.read_view<std::uint32_t>(4, 2)[2], exception::OutOfBounds);
+   ASSERT_THROWS(slice.read_view<std::uint32_t>(4, 4), exception::OutOfBounds);
+
+   auto dword_span = slice.span<std::uint32_t>();
+   ASSERT(dword_span.size() == 4);
+   ASSERT(dword_span.is_valid());
+   ASSERT(dword_span[3] == 0xD1CEFADE);
+   ASSERT(dword_span.subspan(1, 2).front() == 0xEA1DADAB);
+   ASSERT_THROWS(dword_span[4], exception::OutOfBounds);
+
+   std::uint16_t words[2];
+   ASSERT_SUCCESS(slice.read_into<std::uint16_t>(0, words, 2));
+   ASSERT(words[0] == 0xADDE && words[1] == 0xEFBE);
 
    auto search_term = "\xde\xfa\xce\xd1";
    auto search_vec = std::vector<std::uint8_t>(search_term, &search_term[4]);
@@ -43,11 +77,92 @@ int test_memory()
    ASSERT(slice.contains<std::uint32_t>(0xDEADBEEF) == false);
    ASSERT(slice.contains<std::uint32_t>(0xEFBEADDE) == true);
 
+   auto other_data = "\xde\xad\xbe\xef\xab\xad\x1d\xea\xde\xad\xbe\xa7\xde\xfa\xce\xd2";
+   const Memory other_slice(reinterpret_cast<const std::uint8_t *>(other_data), std::strlen(other_data));
+
+   ASSERT(slice.equals(slice));
+   ASSERT(!slice.equals(other_slice));
+   ASSERT(slice.mismatch(other_slice) == 15);
+   ASSERT(slice.compare(other_slice) < 0);
+   ASSERT(other_slice.compare(slice) > 0);
+   ASSERT(slice.equals(0, other_slice, 0, 15));
+   ASSERT(slice.mismatch(subslice_4) == 4);
+   ASSERT(subslice_4.compare(slice) < 0);
+
    auto split = slice.split_at(0x8);
 
    ASSERT(std::memcmp(split.first.ptr(), &data[0], 8) == 0);
    ASSERT(std::memcmp(split.second.ptr(), &data[8], 8) == 0);
 
+   Memory::Domain domain;
+
+   {
+      Memory::Domain::Scope scope(domain);
+      const Memory scoped(reinterpret_cast<const std::uint8_t *>(other_data), 8);
+      auto scoped_view = scoped.subsection(0, 4);
+
+      ASSERT(&scoped.domain() == &domain);
+      ASSERT(&slice.subsection(4, 4).domain() == &Memory::Domain::get_instance());
+      ASSERT(&scoped_view.domain() == &domain);
+      ASSERT(domain.statistics().declarations > 0);
+
+      ASSERT_SUCCESS(domain.teardown());
+      ASSERT(!scoped.is_valid());
+      ASSERT(!scoped_view.is_valid());
+      ASSERT(slice.is_valid());
+   }
+
+   Memory::Domain churn_domain;
+
+   {
+      Memory::Domain::Scope scope(churn_domain);
+      const Memory churned(reinterpret_cast<const std::uint8_t *>(other_data), 16);
+
+      for (std::size_t i=0; i<4; ++i)
+         ASSERT(churned.subsection(i*4, 4).split_at(2).second.is_valid());
+
+      auto warm = churn_domain.statistics();
+      auto warm_heap = heap_allocations.load();
+      bool churn_valid = true;
+
+      for (std::size_t i=0; i<64; ++i)
+         churn_valid = churn_valid && churned.subsection((i % 4)*4, 4).split_at(2).second.is_valid();
+
+      auto churn_heap = heap_allocations.load();
+      auto churn = churn_domain.statistics();
+
+      ASSERT(churn_valid);
+      ASSERT(churn_heap == warm_heap);
+
+      ASSERT(churn.record_allocations == warm.record_allocations);
+      ASSERT(churn.index_allocations == warm.index_allocations);
+      ASSERT(churn.record_reuses > warm.record_reuses);
+   }
+
+   std::uint8_t image[64] = {0};
+   Memory image_memory(image, sizeof(image));
+   std::vector<std::pair<std::size_t,std::size_t>> ranges;
+
+   for (std::size_t offset=0; offset<sizeof(image); offset+=8)
+      ranges.push_back(std::make_pair(offset, 8));
+
+   ASSERT_THROWS(image_memory.subsections({{60, 8}}), exception::InsufficientSize);
+
+   auto views = image_memory.subsections(ranges);
+
+   ASSERT(views.size() == 8);
+   ASSERT(views[3].ptr() == &image[24]);
+   ASSERT(views[3].is_valid());
+   ASSERT(image_memory.domain().parent(&views[3]) == image_memory.interval());
+
+   auto kept = views[7];
+
+   ASSERT_SUCCESS(Memory::destroy_subsections(views));
+   ASSERT(views.empty());
+   ASSERT(!image_memory.domain().has_interval(&image[24], 8));
+   ASSERT(kept.is_valid());
+   ASSERT(image_memory.is_valid());
+
    COMPLETE();
 }
 
@@ -72,7 +187,12 @@ int test_allocated() {
    ASSERT_SUCCESS(buffer.append<std::uint32_t>(0xEA1DADAB));
    ASSERT(buffer.contains<std::uint8_t>(abad1dea, 4));
 
+   auto buffer_span = buffer.span<std::uint32_t>();
+   ASSERT(buffer_span[4] == 0xEA1DADAB);
+
    auto rhs = buffer.split_off(0x8);
+   ASSERT(!buffer_span.is_valid());
+   ASSERT_THROWS(buffer_span[0], exception::InvalidPointer);
    ASSERT(!buffer.contains<std::uint8_t>(abad1dea, 4));
    ASSERT_SUCCESS(buffer.reallocate(0xC));
    ASSERT(buffer.cast_ref<std::uint32_t>(8) == 0x0);
@@ -89,9 +209,236 @@ int test_allocated() {
 
    ASSERT(buffer.to_hex() == "facebabedeadbeefc0ffee74baadf00ddeadbea7defaced1abad1dea");
 
+   AllocatedMemory filled(0x10);
+   ASSERT_SUCCESS(filled.fill<std::uint16_t>(0, 0x10, 0xADDE));
+   ASSERT(filled.to_hex() == "deaddeaddeaddeaddeaddeaddeaddead");
+   ASSERT_SUCCESS(filled.fill<std::uint8_t>(0xC, 4, 0xFF));
+   ASSERT(filled.to_hex() == "deaddeaddeaddeaddeaddeadffffffff");
+   ASSERT_THROWS(filled.fill<std::uint8_t>(0xC, 5, 0xFF), exception::OutOfBounds);
+
+   ASSERT(filled.atomic_fetch_add<std::uint32_t>(0, 1) == 0xADDEADDE);
+   ASSERT(filled.atomic_load<std::uint32_t>(0) == 0xADDEADDF);
+   ASSERT_SUCCESS(filled.atomic_store<std::uint32_t>(0, 0xADDEADDE, std::memory_order_release));
+   ASSERT_THROWS(filled.atomic_load<std::uint32_t>(2), exception::BadAlignment);
+
+   ASSERT_SUCCESS(filled.copy_from(buffer, 0, 0, 4));
+   ASSERT(filled.to_hex() == "facebabedeaddeaddeaddeadffffffff");
+   ASSERT_SUCCESS(filled.move_within(0, 2, 8));
+   ASSERT(filled.to_hex() == "facefacebabedeaddeaddeadffffffff");
+   ASSERT_SUCCESS(filled.move_within(4, 0, 8));
+   ASSERT(filled.to_hex() == "babedeaddeaddeaddeaddeadffffffff");
+
+   AllocatedMemory unfilled(4, FillPolicy::None);
+   ASSERT(unfilled.fill_policy() == FillPolicy::None);
+   ASSERT_SUCCESS(unfilled.write<std::uint32_t>(0, 0xEFBEADDE));
+   ASSERT_SUCCESS(unfilled.set_fill_policy(FillPolicy::ZeroOnAllocate));
+   ASSERT_SUCCESS(unfilled.reallocate(8));
+   ASSERT(unfilled.to_hex() == "deadbeef00000000");
+
+   AllocatedMemory<ReallocAllocator<std::uint8_t>> growable(4, FillPolicy::ZeroOnAllocate);
+   ASSERT_SUCCESS(growable.write<std::uint32_t>(0, 0xEFBEADDE));
+   auto growable_view = growable.subsection(0, 2);
+   ASSERT_SUCCESS(growable.reallocate(0x200000));
+   ASSERT(growable_view.is_valid());
+   ASSERT(growable.read<std::uint32_t>(0, 1)[0] == 0xEFBEADDE);
+   ASSERT_SUCCESS(growable.reallocate(8));
+   ASSERT(growable.to_hex() == "deadbeef00000000");
+
+   AllocatedMemory<AlignedAllocator<std::uint32_t, alignment::Page>> aligned(16);
+   ASSERT(reinterpret_cast<std::uintptr_t>(aligned.ptr()) % alignment::Page == 0);
+   ASSERT_SUCCESS(aligned.reallocate(0x80000));
+   ASSERT(reinterpret_cast<std::uintptr_t>(aligned.ptr()) % alignment::HugePage == 0);
+   ASSERT(aligned.read<std::uint32_t>(0x7FFFF, 1)[0] == 0);
+
+   std::vector<std::uint8_t> external = { 0xDE, 0xAD, 0xBE, 0xEF };
+   auto external_data = external.data();
+   AllocatedMemory adopted;
+   ASSERT_SUCCESS(adopted.adopt(std::move(external)));
+   ASSERT(adopted.ptr() == external_data);
+   ASSERT(adopted.to_hex() == "deadbeef");
+
+   auto adopted_view = adopted.subsection(0, 2);
+   auto released = adopted.release();
+   ASSERT(released.first.get() == external_data);
+   ASSERT(released.second == 4);
+   ASSERT(!adopted_view.is_valid());
+   ASSERT_THROWS(adopted.release(), exception::NotAllocated);
+
+   AllocatedMemory edited(8);
+   ASSERT_SUCCESS(edited.write<std::uint32_t>(0, 0xEFBEADDE));
+   auto edited_view = edited.subsection(0, 4);
+
+   WriteBatch<> edits;
+   ASSERT_SUCCESS(edits.write<std::uint32_t>(4, 0x0DF0ADBA));
+   ASSERT_SUCCESS(edits.insert<std::uint8_t>(0, facebabe, 4));
+   ASSERT_SUCCESS(edits.erase(2, 2));
+   ASSERT_SUCCESS(edited.apply(edits));
+   ASSERT(edited.to_hex() == "facebabedeadbaadf00d");
+   ASSERT(edited_view.is_valid());
+
+   ASSERT_SUCCESS(edits.erase(8, 4));
+   ASSERT_THROWS(edited.apply(edits), exception::OutOfBounds);
+   ASSERT(edited.to_hex() == "facebabedeadbaadf00d");
+
+   AllocatedMemory<std::allocator<std::uint32_t>> pinnable(4);
+   auto pinnable_view = pinnable.subsection(1, 2);
+
+   {
+      auto pin = pinnable_view.pin<std::uint32_t>();
+      ASSERT(pin.size() == 2);
+      pin[1] = 0xDEADBEEF;
+      ASSERT(pinnable.read<std::uint32_t>(2, 1)[0] == 0xDEADBEEF);
+      ASSERT(pinnable.is_pinned());
+      ASSERT_THROWS(pinnable.reallocate(8), exception::Pinned);
+      ASSERT_THROWS(pinnable.deallocate(), exception::Pinned);
+
+      auto before = pinnable.to_hex();
+      ASSERT_THROWS(pinnable.erase(0, 1), exception::Pinned);
+      ASSERT(pinnable.to_hex() == before);
+   }
+
+   ASSERT(!pinnable.is_pinned());
+   ASSERT_SUCCESS(pinnable.reallocate(8));
+
+   {
+      Memory::Domain copy_domain;
+      Memory::Domain::Scope scope(copy_domain);
+      AllocatedMemory<> original(4);
+      SmallMemory<16> small_original(4);
+
+      Memory::Domain::Scope outside(Memory::Domain::get_instance());
+      AllocatedMemory<> copied(original);
+      SmallMemory<16> small_copied(small_original);
+      ASSERT(&copied.domain() == &copy_domain);
+      ASSERT(&small_copied.domain() == &copy_domain);
+   }
+
+   {
+      Pin<std::uint32_t> outliving;
+
+      {
+         AllocatedMemory<std::allocator<std::uint32_t>> doomed(4);
+         outliving = doomed.pin<std::uint32_t>();
+      }
+
+      ASSERT_THROWS((void)outliving.span(), exception::InvalidPointer);
+
+      AllocatedMemory<std::allocator<std::uint32_t>> reused(4);
+      auto reused_pin = reused.pin<std::uint32_t>();
+      ASSERT_SUCCESS(outliving.release());
+      ASSERT(reused.is_pinned());
+   }
+
    auto invalid_slice = buffer.subsection(0, buffer.size());
    buffer.deallocate();
-   ASSERT_THROWS(std::memcmp(invalid_slice.read<std::uint8_t>(0, 4).data(), "\xfa\xce\xba\xbe", 4) == 0, exception::InvalidPointer);
+   ASSERT_THROWS(std::memcmp(invalid_slice.read_view<std::uint8_t>(0, 4).data(), "\xfa\xce\xba\xbe", 4) == 0, exception::InvalidPointer);
+
+   COMPLETE();
+}
+
+int test_small()
+{
+   INIT();
+
+   SmallMemory<16> small(8);
+   ASSERT(small.is_inline());
+   ASSERT_SUCCESS(small.write<std::uint32_t>(0, 0xEFBEADDE));
+   ASSERT_SUCCESS(small.append<std::uint32_t>(0xEA1DADAB));
+   ASSERT(small.is_inline());
+   ASSERT(small.to_hex() == "deadbeef00000000abad1dea");
+
+   std::uint64_t zero = 0;
+   ASSERT_SUCCESS(small.append<std::uint64_t>(zero));
+   ASSERT(!small.is_inline());
+   ASSERT(small.to_hex() == "deadbeef00000000abad1dea0000000000000000");
+
+   // without zeroing on growth, only the wipe on shrink keeps trimmed bytes from coming back
+   SmallMemory<16> trimmed(8);
+   trimmed.set_fill_policy(FillPolicy::WipeOnFree);
+   ASSERT_SUCCESS(trimmed.write<std::uint32_t>(4, 0xEA1DADAB));
+   ASSERT_SUCCESS(trimmed.reallocate(4));
+   ASSERT_SUCCESS(trimmed.reallocate(8));
+   ASSERT(trimmed.is_inline());
+   ASSERT(trimmed.to_hex() == "0000000000000000");
+
+   InlineArray<std::uint32_t, 2> inline_array;
+   ASSERT_SUCCESS(inline_array.push_back(0xEFBEADDE));
+   ASSERT_SUCCESS(inline_array.push_back(0xEA1DADAB));
+   ASSERT(inline_array.is_inline());
+   ASSERT_SUCCESS(inline_array.push_back(0xA7BEADDE));
+   ASSERT(!inline_array.is_inline());
+   ASSERT(inline_array.pop_back() == 0xA7BEADDE);
+   ASSERT(inline_array.to_vec() == std::vector<std::uint32_t>({ 0xEFBEADDE, 0xEA1DADAB }));
+
+   COMPLETE();
+}
+
+int test_shared()
+{
+   INIT();
+
+   std::uint8_t data[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xAB, 0xAD, 0x1D, 0xEA };
+   SharedMemory<> shared(&data[0], sizeof(data));
+   auto block = shared.block_interval();
+   ASSERT(shared.is_unique());
+
+   auto right = shared.split_off(4);
+   ASSERT(shared.handle_count() == 2);
+   ASSERT(shared.to_hex() == "deadbeef");
+   ASSERT(right.to_hex() == "abad1dea");
+   ASSERT(right.ptr() == shared.eob());
+   ASSERT(right.block_interval() == block);
+   ASSERT_THROWS((void)shared.split_off(4), exception::OutOfBounds);
+
+   auto view = right.subsection(0, 2);
+   ASSERT_SUCCESS(shared.deallocate());
+   ASSERT(right.is_unique());
+   ASSERT(view.is_valid());
+   ASSERT(right.read<std::uint8_t>(0, 2) == std::vector<std::uint8_t>({ 0xAB, 0xAD }));
+
+   ASSERT_SUCCESS(right.deallocate());
+   ASSERT(!view.is_valid());
+
+   SharedMemory<> erased(&data[0], sizeof(data));
+   auto survivor = erased.slice(4, 4);
+
+   ASSERT_SUCCESS(erased.erase(0, 2));
+   ASSERT(erased.to_hex() == "beefabad1dea");
+   ASSERT(survivor.to_hex() == "abad1dea");
+   ASSERT(survivor.block_interval() != erased.block_interval());
+
+   COMPLETE();
+}
+
+int test_virtual()
+{
+   INIT();
+
+   VirtualMemory buffer(4, 0x100000);
+   auto base = buffer.ptr();
+   ASSERT_SUCCESS(buffer.write<std::uint32_t>(0, 0xEFBEADDE));
+
+   auto head = buffer.span<std::uint8_t>(0, 2);
+   ASSERT_SUCCESS(buffer.append<std::uint32_t>(0xEA1DADAB));
+   ASSERT(buffer.ptr() == base);
+   ASSERT(head.is_valid());
+   ASSERT(buffer.to_hex() == "deadbeefabad1dea");
+
+   ASSERT_SUCCESS(buffer.reallocate(0x10000));
+   ASSERT(buffer.ptr() == base);
+   ASSERT(buffer.committed_size() == 0x10000);
+
+   auto tail = buffer.subsection(0x8000, 0x1000);
+   ASSERT_SUCCESS(buffer.reallocate(8));
+   ASSERT(!tail.is_valid());
+   ASSERT(head.is_valid());
+   ASSERT(buffer.committed_size() < 0x10000);
+
+   ASSERT_SUCCESS(buffer.reallocate(0x2000));
+   auto far = buffer.span<std::uint8_t>(0x1000, 4);
+   ASSERT_SUCCESS(buffer.reallocate(8));
+   ASSERT(!far.is_valid());
+   ASSERT_THROWS(buffer.reallocate(0x100001), exception::ReservationExceeded);
 
    COMPLETE();
 }
@@ -110,8 +457,18 @@ int test_transparent()
    ASSERT_THROWS(transparent.insert<std::uint32_t>(8, 0xBAADF00D), exception::NotAllocated);
    ASSERT_THROWS((void)transparent.split_off(8), exception::NotAllocated);
 
+   const AllocatedMemory<> &const_allocated = allocated;
+   const TransparentMemory<> &const_transparent = transparent;
+
    ASSERT_SUCCESS(transparent.consume());
+   ASSERT(transparent.is_allocated());
+   ASSERT(transparent.is_shared());
+   ASSERT(const_transparent.ptr() == const_allocated.ptr());
+   ASSERT(transparent.ptr() == allocated.ptr());
+   ASSERT(transparent.is_shared());
+   ASSERT_SUCCESS(transparent.write<std::uint8_t>(0, 0xDE));
    ASSERT(transparent.ptr() != allocated.ptr());
+   ASSERT(!transparent.is_shared());
    ASSERT(transparent.is_allocated());
    ASSERT(std::memcmp(allocated.ptr(), transparent.ptr(), allocated.size()) == 0);
    ASSERT_SUCCESS(transparent.append<std::uint32_t>(0xEA1DADAB));
@@ -119,6 +476,46 @@ int test_transparent()
    ASSERT(std::memcmp(allocated.ptr(), transparent.ptr(), std::min(allocated.size(),transparent.size())) != 0);
    ASSERT(transparent.to_hex() == "deadbeefabad1deabaadf00ddeadbea7defaced1abad1dea");
 
+   TransparentMemory borrower(const_allocated.ptr(), const_allocated.size());
+   ASSERT_SUCCESS(borrower.consume());
+   TransparentMemory borrower_copy(borrower);
+   ASSERT(borrower_copy.is_shared());
+   ASSERT_SUCCESS(allocated.write<std::uint8_t>(0, 0xFF));
+   ASSERT(!borrower.is_shared());
+   ASSERT(!borrower_copy.is_shared());
+   ASSERT(borrower.to_hex() == "deadbeefabad1deadeadbea7defaced1");
+   ASSERT_SUCCESS(allocated.deallocate());
+   ASSERT(borrower_copy.to_hex() == "deadbeefabad1deadeadbea7defaced1");
+
+   COMPLETE();
+}
+
+int test_piece_table()
+{
+   INIT();
+
+   auto data = "\xde\xad\xbe\xef\xab\xad\x1d\xea";
+   Memory region(data, std::strlen(data));
+   PieceTable table(region);
+   ASSERT(table.size() == 8);
+
+   ASSERT_SUCCESS(table.insert<std::uint32_t>(4, 0x0DF0ADBA));
+   ASSERT_SUCCESS(table.insert<std::uint8_t>(0, 0xFF));
+   ASSERT_SUCCESS(table.erase(1, 4));
+   ASSERT_THROWS(table.erase(8, 2), exception::OutOfBounds);
+   ASSERT(table.size() == 9);
+   ASSERT(table.to_hex() == "ffbaadf00dabad1dea");
+   ASSERT(region.to_hex() == "deadbeefabad1dea");
+
+   std::uint8_t straddle[] = {0x0D, 0xAB};
+   ASSERT(table.search<std::uint8_t>(straddle, 2) == std::vector<std::size_t>({ 4 }));
+   ASSERT(table.contains<std::uint32_t>(0xEA1DADAB));
+   ASSERT(table.read<std::uint32_t>(1, 1)[0] == 0x0DF0ADBA);
+
+   auto flat = table.flatten();
+   ASSERT(flat.size() == table.size());
+   ASSERT(flat.to_hex() == table.to_hex());
+
    COMPLETE();
 }
 
@@ -182,11 +579,246 @@ int test_array()
    ASSERT(dword_array.front() == 0xEFBEADDE);
    ASSERT(dword_array.back() == 0xD1CEFADE);
 
+   Array<std::uint32_t> dword_copy(dword_array.ptr(), dword_array.size(), true);
+   ASSERT(dword_copy == dword_array);
+   ASSERT_SUCCESS(dword_copy[2] = 0xBAADF00D);
+   ASSERT(dword_copy != dword_array);
+   ASSERT(dword_copy.mismatch(dword_array) == 2);
+   ASSERT(dword_copy.compare(dword_array) > 0);
+
+   ASSERT_SUCCESS(std::sort(dword_copy.begin(), dword_copy.end()));
+   ASSERT(std::is_sorted(dword_copy.begin(), dword_copy.end()));
+   ASSERT(dword_copy.front() == 0xBAADF00D);
+   ASSERT(dword_copy.back() == 0xEFBEADDE);
+   ASSERT(std::count(dword_array.begin(), dword_array.end(), 0xD1CEFADE) == 1);
+#if PARFAIT_ITERATOR_DEBUG
+   ASSERT_THROWS(*dword_copy.end(), exception::OutOfBounds);
+#endif
+
    ASSERT_SUCCESS(dword_array.consume());
    ASSERT_SUCCESS(dword_array.push_front(0x0DF0ADBA));
    ASSERT_SUCCESS(dword_array.push_back(0x0DF0ADBA));
    ASSERT_SUCCESS(dword_array.reverse());
    ASSERT(dword_array.to_hex() == "baadf00ddefaced1deadbea7abad1deadeadbeefbaadf00d");
+   ASSERT(dword_array.pop_front() == 0x0DF0ADBA);
+   ASSERT(dword_array.to_hex() == "defaced1deadbea7abad1deadeadbeefbaadf00d");
+
+   Array<std::uint32_t> counters(4);
+   std::uint32_t increments[] = { 1, 2, 3, 4 };
+   ASSERT(counters.atomic_fetch_add(1, 5) == 0);
+   ASSERT_SUCCESS(counters.atomic_fetch_add(0, increments, 4));
+   ASSERT(counters.atomic_load(1) == 7);
+   std::uint32_t expected = 7;
+   ASSERT(counters.atomic_compare_exchange(1, expected, 0xF0));
+   ASSERT(counters.atomic_fetch_or(1, 0x0F) == 0xF0);
+   ASSERT(counters.atomic_exchange(3, 0) == 4);
+   ASSERT_THROWS(counters.atomic_load(counters.size()), exception::OutOfBounds);
+
+   Array<std::uint32_t> owner(8);
+   auto window = owner.subsection(2, 4);
+   auto halves = owner.split_at(4);
+   ASSERT(window.is_valid());
+   ASSERT(halves.second.is_valid());
+   ASSERT_SUCCESS(owner.deallocate());
+   ASSERT(!window.is_valid());
+   ASSERT(!halves.first.is_valid());
+   ASSERT(!halves.second.is_valid());
+
+   COMPLETE();
+}
+
+int test_append()
+{
+   INIT();
+
+   AppendBuffer<std::uint32_t> records;
+   std::vector<std::thread> producers;
+
+   for (std::uint32_t producer=0; producer<4; ++producer)
+      producers.emplace_back([&records, producer]() {
+         for (std::uint32_t i=0; i<0x1000; ++i)
+            records.push_back((producer << 16) | i);
+      });
+
+   for (auto &producer : producers)
+      producer.join();
+
+   ASSERT(records.size() == 0x4000);
+
+   auto snapshot = records.snapshot();
+   std::uint32_t next[4] = { 0, 0, 0, 0 };
+   bool ordered = true;
+
+   for (auto record : snapshot)
+      ordered = ordered && (record & 0xFFFF) == next[record >> 16]++;
+
+   ASSERT(snapshot.size() == 0x4000);
+   ASSERT(ordered);
+
+   std::size_t segmented = 0;
+
+   for (auto &segment : records.segments())
+      segmented += segment.size();
+
+   ASSERT(segmented == 0x4000);
+
+   std::uint32_t batch[] = { 0xDEADBEEF, 0xABAD1DEA };
+   ASSERT(records.append(batch, 2) == 0x4000);
+   ASSERT(records[0x4001] == 0xABAD1DEA);
+   ASSERT_THROWS(records[0x4002], exception::OutOfBounds);
+
+   COMPLETE();
+}
+
+int test_flat()
+{
+   INIT();
+
+   FlatIntervalIndex<Memory::IntervalType, 4> index;
+
+   for (std::uintptr_t low=0x1000; low<0x2000; low+=0x100)
+      ASSERT(index.insert(Memory::IntervalType(low, low+0x80)));
+
+   ASSERT(index.insert(Memory::IntervalType(0x1000, 0x1800)));
+   ASSERT(!index.insert(Memory::IntervalType(0x1000, 0x1800)));
+   ASSERT(index.size() == 17);
+   ASSERT(index.has(Memory::IntervalType(0x1F00, 0x1F80)));
+   ASSERT(index.covers(0x1700, 0x1800));
+   ASSERT(index.covers(0x1900, 0x1980));
+   ASSERT(!index.covers(0x1980, 0x1A00));
+   ASSERT(!index.covers(0x800, 0x900));
+
+   ASSERT(index.erase(Memory::IntervalType(0x1000, 0x1800)));
+   ASSERT(!index.covers(0x1700, 0x1800));
+   ASSERT(index.covers(0x1700, 0x1780));
+
+   std::size_t contained = 0;
+   index.containing(0x1900, 0x1980, [&contained](const Memory::IntervalType &, std::size_t) { ++contained; });
+   ASSERT(contained == 1);
+
+   std::size_t overlapped = 0;
+   index.overlapping(0x1170, 0x1310, [&overlapped](const Memory::IntervalType &, std::size_t) { ++overlapped; });
+   ASSERT(overlapped == 3);
+   overlapped = 0;
+   index.overlapping(0x1080, 0x1100, [&overlapped](const Memory::IntervalType &, std::size_t) { ++overlapped; });
+   ASSERT(overlapped == 0);
+
+   struct Record
+   {
+      std::uint32_t value = 0;
+      void reset() { this->value = 0; }
+   };
+
+   SlotPool<Record> slots;
+   auto slot = slots.acquire();
+   slots[slot].value = 1;
+   slots.release(slot);
+
+   ASSERT(slots.acquire() == slot);
+   ASSERT(slots[slot].value == 0);
+   ASSERT(slots.allocations() == 1);
+   ASSERT(slots.reuses() == 1);
+
+   FlatSet<std::uint32_t, 2> set;
+
+   for (std::uint32_t value=0; value<8; ++value)
+      ASSERT(set.insert(value));
+
+   ASSERT(!set.insert(3));
+   ASSERT(set.erase(3) == 1);
+   ASSERT(set.erase(3) == 0);
+   ASSERT(set.size() == 7);
+   ASSERT(set.find(7) != set.end());
+
+   std::vector<std::uint32_t> more = {7, 8, 9, 9, 10};
+   std::vector<std::uint32_t> fewer = {0, 8, 10, 11};
+
+   ASSERT(set.insert(more.begin(), more.end()) == 3);
+   ASSERT(*(set.end()-1) == 10);
+   ASSERT(set.erase(fewer.begin(), fewer.end()) == 3);
+   ASSERT(set.size() == 7);
+   ASSERT(*set.begin() == 1);
+
+   COMPLETE();
+}
+
+int test_pool()
+{
+   INIT();
+
+   ThreadPool pool(3);
+   std::vector<std::atomic<int>> visits(0x10000);
+
+   ASSERT(pool.parallel_for(visits.size(), [&visits](std::size_t begin, std::size_t end) {
+      for (auto i=begin; i<end; ++i)
+         ++visits[i];
+   }, 0x100));
+   ASSERT(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &visit) { return visit == 1; }));
+
+   ASSERT_THROWS(pool.parallel_for(0x1000, [](std::size_t begin, std::size_t) {
+      if (begin == 0x800) { throw exception::ZeroSize(); }
+   }, 0x10), exception::ZeroSize);
+
+   Cancellation cancellation;
+   std::atomic<std::size_t> chunks(0);
+
+   ASSERT(!pool.parallel_for(0x1000, [&](std::size_t, std::size_t) {
+      if (++chunks == 4) { cancellation.cancel(); }
+   }, 1, &cancellation));
+   ASSERT(chunks < 0x1000);
+
+   std::vector<std::size_t> bad_cpus = { std::numeric_limits<std::size_t>::max() };
+   ASSERT_THROWS(ThreadPool(1, bad_cpus), exception::OutOfBounds);
+
+   // big enough to be split across the shared pool
+   std::uint8_t pattern[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xAB };
+   auto size = Memory::ParallelThreshold*2 + 3;
+   AllocatedMemory<> left(size), right(size);
+
+   ASSERT_SUCCESS(left.fill<std::uint8_t>(0, size, pattern, 5));
+   ASSERT_SUCCESS(right.fill<std::uint8_t>(0, size, pattern, 5));
+   ASSERT(left.cast_ref<std::uint8_t>(size-1) == pattern[(size-1) % 5]);
+   ASSERT(!left.mismatch(right).has_value());
+
+   right.cast_ref<std::uint8_t>(size-2) = 0;
+   right.cast_ref<std::uint8_t>(Memory::ParallelThreshold+1) = 0;
+   ASSERT(*left.mismatch(right) == Memory::ParallelThreshold+1);
+
+   std::uint8_t needle[] = { 0xAB, 0xDE };
+   ASSERT(left.search<std::uint8_t>(needle, 2).size() == (size-1) / 5);
+   ASSERT(left.to_hex().substr(0, 12) == "deadbeefabde");
+
+   COMPLETE();
+}
+
+int test_ring()
+{
+   INIT();
+
+   Ring<std::uint32_t> ring(4);
+   ASSERT(ring.capacity() == 4);
+   ASSERT(ring.is_empty());
+   ASSERT(!ring.pop_front().has_value());
+
+   ASSERT_SUCCESS(ring.push_back(0xEA1DADAB));
+   ASSERT_SUCCESS(ring.push_back(0xA7BEADDE));
+   ASSERT_SUCCESS(ring.push_front(0xEFBEADDE));
+   ASSERT(ring.size() == 3);
+   ASSERT(ring.front() == 0xEFBEADDE);
+   ASSERT(ring[2] == 0xA7BEADDE);
+   ASSERT(ring.segments().first.size() == 1);
+   ASSERT(ring.segments().second.size() == 2);
+   ASSERT(ring.segments().first[0] == 0xEFBEADDE);
+   ASSERT(ring.segments().second[1] == 0xA7BEADDE);
+
+   ASSERT_SUCCESS(ring.push_back(0xD1CEFADE));
+   ASSERT_SUCCESS(ring.push_back(0x0DF0ADBA));
+   ASSERT(ring.capacity() == 8);
+   ASSERT(ring.to_vec() == std::vector<std::uint32_t>({ 0xEFBEADDE, 0xEA1DADAB, 0xA7BEADDE, 0xD1CEFADE, 0x0DF0ADBA }));
+   ASSERT(ring.pop_front() == 0xEFBEADDE);
+   ASSERT(ring.pop_back() == 0x0DF0ADBA);
+   ASSERT(ring.size() == 3);
+   ASSERT_THROWS(ring[3], exception::OutOfBounds);
 
    COMPLETE();
 }
@@ -229,15 +861,39 @@ main
    LOG_INFO("Testing AllocatedMemory objects.");
    PROCESS_RESULT(test_allocated);
 
+   LOG_INFO("Testing SmallMemory objects.");
+   PROCESS_RESULT(test_small);
+
+   LOG_INFO("Testing SharedMemory objects.");
+   PROCESS_RESULT(test_shared);
+
+   LOG_INFO("Testing VirtualMemory objects.");
+   PROCESS_RESULT(test_virtual);
+
    LOG_INFO("Testing TransparentMemory objects.");
    PROCESS_RESULT(test_transparent);
 
+   LOG_INFO("Testing PieceTable objects.");
+   PROCESS_RESULT(test_piece_table);
+
    LOG_INFO("Testing Pointer objects.");
    PROCESS_RESULT(test_pointer);
 
    LOG_INFO("Testing Array objects.");
    PROCESS_RESULT(test_array);
 
+   LOG_INFO("Testing AppendBuffer objects.");
+   PROCESS_RESULT(test_append);
+
+   LOG_INFO("Testing flat index objects.");
+   PROCESS_RESULT(test_flat);
+
+   LOG_INFO("Testing ThreadPool objects.");
+   PROCESS_RESULT(test_pool);
+
+   LOG_INFO("Testing Ring objects.");
+   PROCESS_RESULT(test_ring);
+
    LOG_INFO("Testing Variadic objects.");
    PROCESS_RESULT(test_variadic);
 